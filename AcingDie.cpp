@@ -16,6 +16,7 @@ You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "AcingDie.h"
+#include "ImportanceSampler.h"
 
 #include <string>
 #include <limits>
@@ -26,29 +27,69 @@ AcingDie::AcingDie(unsigned int _nSides): nSides(_nSides) {
         throw std::string{"AcingDie must have >0 sides."};
 }
 
+void AcingDie::setSides(unsigned int nSides_) {
+    if (nSides_==0)
+        throw std::string{"AcingDie must have >0 sides."};
+    nSides = nSides_;
+}
+
 double AcingDie::massFunction(double dX) const {
     if (dX<.0)
         return .0;
+    return pmfAt(std::int64_t(std::floor(dX)));
+}
 
-    double dIntegerPartOfX{.0};
-    std::modf(dX, &dIntegerPartOfX);
-    if(std::fmod(dIntegerPartOfX,(double)nSides) == 0.) {
+double AcingDie::pmfAt(std::int64_t n) const {
+    if (n<1 || n%nSides==0)
         return .0;
-    }
-    double dAces = std::floor(dIntegerPartOfX/nSides);
-    return std::pow(1.0/double(nSides), double(dAces)+1.0);
+    std::int64_t nAces = n/nSides;
+    return std::pow(1.0/double(nSides), double(nAces)+1.0);
 }
 
-double AcingDie::distributionFunction(double dX) const {
-    if (dX<1.)
+double AcingDie::cdfAt(std::int64_t n) const {
+    if (n<1)
         return .0;
-    double dIntegerPartOfX{.0};
-    std::modf(dX, &dIntegerPartOfX);
-    double dAces = std::floor(dIntegerPartOfX/nSides);
-    double dDist = nSides*(dAces+1)-dIntegerPartOfX;
-    return 1.0 - (std::pow(1.0/double(nSides), double(dAces)) * double(dDist) / double(nSides));
+    std::int64_t nAces = n/nSides;
+    std::int64_t nDist = std::int64_t(nSides)*(nAces+1)-n;
+    return 1.0 - (std::pow(1.0/double(nSides), double(nAces)) * double(nDist) / double(nSides));
+}
+
+std::int64_t AcingDie::getIntMinimum(void) const {
+    return 1;
+}
+
+std::int64_t AcingDie::getIntMaximum(void) const {
+    return nUnbounded;
+}
+
+// The result is nSides*K+R with K ~ Geometric(1/nSides) aces and R uniform on 1..nSides-1.
+double AcingDie::mean(void) const {
+    if (nSides<2)
+        throw std::string{"A one sided AcingDie explodes forever."};
+    double dSides = double(nSides);
+    return dSides/(dSides-1.) + dSides/2.;
+}
+
+double AcingDie::variance(void) const {
+    if (nSides<2)
+        throw std::string{"A one sided AcingDie explodes forever."};
+    double dSides = double(nSides);
+    return dSides*dSides*dSides/((dSides-1.)*(dSides-1.)) + (dSides*dSides-2.*dSides)/12.;
+}
+
+std::int64_t AcingDie::sample(ImportanceSampler& sampler) const {
+    if (nSides<2)
+        throw std::string{"A one sided AcingDie explodes forever."};
+    std::int64_t nTotal = 0;
+    while (sampler.explode(1./double(nSides)))
+        nTotal += nSides;
+    return nTotal+sampler.uniformInteger(1, nSides-1);
+}
+
+std::string AcingDie::getDescription(void) const {
+    return "AcingDie("+std::to_string(nSides)+")";
 }
 
-double AcingDie::getMinimum(void) const {
-    return 1.;
+std::shared_ptr<StochasticObject> AcingDie::withChildren(const std::vector<std::shared_ptr<StochasticObject>>&) const {
+    return std::make_shared<AcingDie>(*this);
 }
@@ -27,7 +27,17 @@ class AcingDie: public StochasticObject {
         AcingDie(unsigned int _nSides);
         virtual ~AcingDie(void) = default;
         virtual double massFunction(double x) const;
-        virtual double distributionFunction(double x) const;
-        virtual double getMinimum(void) const;
+        virtual double cdfAt(std::int64_t n) const;
+        virtual double pmfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+
+        unsigned int getSides(void) const {return nSides;};
+        void setSides(unsigned int nSides_);
 };
 #endif
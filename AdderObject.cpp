@@ -15,20 +15,83 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
+#include <algorithm>
+#include <cmath>
+
 #include "AdderObject.h"
+#include "DiceSumKernel.h"
+#include "TabulatedObject.h"
+#include "ImportanceSampler.h"
 
 AdderObject::AdderObject(const std::shared_ptr<StochasticObject>& pLeftSummand_,const std::shared_ptr<StochasticObject>& pRightSummand_):
-    pLeftSummand(pLeftSummand_), pRightSummand(pRightSummand_) {}
+    pLeftSummand(pLeftSummand_), pRightSummand(pRightSummand_), nDice(0) {
+    nDice = DiceSumKernel::countChildDice(*this);
+}
 
-double AdderObject::distributionFunction(double dX) const{
+double AdderObject::cdfAt(std::int64_t n) const{
     double dProbability = .0;
-    for (double dZ = pLeftSummand->getMinimum(); dZ<=dX; ++dZ) {
-        dProbability += (pLeftSummand->distributionFunction(dZ)-pLeftSummand->distributionFunction(dZ-1.))*pRightSummand->distributionFunction(dX-dZ);
+    std::int64_t nUpper = std::min(pLeftSummand->getIntMaximum(), addSaturated(n, -pRightSummand->getIntMinimum()));
+    for (std::int64_t nZ = pLeftSummand->getIntMinimum(); nZ<=nUpper; ++nZ) {
+        dProbability += pLeftSummand->pmfAt(nZ)*pRightSummand->cdfAt(n-nZ);
     }
     return dProbability;
 }
 
-double AdderObject::getMinimum(void) const {
-    return pLeftSummand->getMinimum() + pRightSummand->getMinimum();
+std::int64_t AdderObject::getIntMinimum(void) const {
+    return pLeftSummand->getIntMinimum() + pRightSummand->getIntMinimum();
+}
+
+// The summands are independent, so both means and variances add up.
+double AdderObject::mean(void) const {
+    return pLeftSummand->mean()+pRightSummand->mean();
+}
+
+double AdderObject::variance(void) const {
+    return pLeftSummand->variance()+pRightSummand->variance();
+}
+
+std::int64_t AdderObject::sample(ImportanceSampler& sampler) const {
+    return addSaturated(pLeftSummand->sample(sampler), pRightSummand->sample(sampler));
+}
+
+std::int64_t AdderObject::getIntMaximum(void) const {
+    return addSaturated(pLeftSummand->getIntMaximum(), pRightSummand->getIntMaximum());
+}
+
+std::string AdderObject::getDescription(void) const {
+    return "Adder("+pLeftSummand->getDescription()+","+pRightSummand->getDescription()+")";
 }
 
+std::vector<std::shared_ptr<StochasticObject>> AdderObject::getChildren(void) const {
+    return {pLeftSummand, pRightSummand};
+}
+
+std::shared_ptr<StochasticObject> AdderObject::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<AdderObject>(vChildren.at(0), vChildren.at(1));
+}
+
+std::shared_ptr<TabulatedObject> AdderObject::tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const {
+    return TabulatedObject::add(*vChildren.at(0), *vChildren.at(1), dEpsilon);
+}
+
+bool AdderObject::canTabulateDirectly(void) const {
+    return nDice>0;
+}
+
+std::shared_ptr<TabulatedObject> AdderObject::tabulateDirectly(double dEpsilon, std::size_t nMaxSize) const {
+    return DiceSumKernel::tabulate(*this, dEpsilon, nMaxSize);
+}
+
+// cdfAt walks the left summand and looks both summands up at every step; combining the tables
+// multiplies every pair of values.
+StochasticObject::CostEstimate AdderObject::estimateCost(const std::vector<CostEstimate>& vChildren, double) const {
+    auto &left = vChildren.at(0);
+    auto &right = vChildren.at(1);
+    double dPairs = left.dSupport*right.dSupport;
+    // Sums of dice are tabulated in one pass per die, without child tables.
+    if (nDice>0)
+        return {left.dSupport+right.dSupport, left.dSupport*(1.+2.*left.dQueryCost+right.dQueryCost),
+                left.dSetupCost+right.dSetupCost, 4.*double(nDice)*(left.dSupport+right.dSupport)};
+    return {left.dSupport+right.dSupport, left.dSupport*(1.+2.*left.dQueryCost+right.dQueryCost),
+            left.dSetupCost+right.dSetupCost, dPairs*(1.+std::log2(dPairs+1.))};
+}
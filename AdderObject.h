@@ -25,12 +25,26 @@ class AdderObject: public StochasticObject {
     private:
         std::shared_ptr<StochasticObject> pLeftSummand;
         std::shared_ptr<StochasticObject> pRightSummand;
+        std::size_t nDice;
     public:
         AdderObject(const std::shared_ptr<StochasticObject>& pLeftSummand_, const std::shared_ptr<StochasticObject>& pRightSummand_);
         virtual ~AdderObject(void) = default;
 
-        virtual double distributionFunction(double dX) const;
-        virtual double getMinimum(void) const;
+        virtual double cdfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+        virtual bool canTabulateDirectly(void) const;
+        // Dice below this node if it only sums acing dice and modifiers, otherwise 0 (see DiceSumKernel).
+        std::size_t getDiceCount(void) const {return nDice;};
+        virtual std::shared_ptr<TabulatedObject> tabulateDirectly(double dEpsilon, std::size_t nMaxSize=1<<20) const;
+        virtual std::shared_ptr<TabulatedObject> tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const;
+        virtual CostEstimate estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const;
 
 };
 
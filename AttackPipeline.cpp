@@ -0,0 +1,163 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <algorithm>
+
+#include "AcingDie.h"
+#include "MaxConnector.h"
+#include "RaiseCounter.h"
+#include "FlatMod.h"
+#include "AdderObject.h"
+#include "BranchObject.h"
+#include "ConstantObject.h"
+#include "WoundCalculatorObject.h"
+#include "ParallelTabulator.h"
+#include "StreamingTabulator.h"
+
+#include "AttackPipeline.h"
+
+AttackPipeline::AttackPipeline(unsigned int nAttackDieSides_, unsigned int nWildDieSides_, double dMod_,
+                               const std::vector<unsigned int>& vDamageDice_, unsigned int nRaiseDieSides_,
+                               double dToughness_, bool bShaken_, double dEpsilon_):
+        nAttackDieSides(nAttackDieSides_), nWildDieSides(nWildDieSides_), dMod(dMod_),
+        vDamageDice(vDamageDice_), nRaiseDieSides(nRaiseDieSides_), dToughness(dToughness_),
+        bShaken(bShaken_), dEpsilon(dEpsilon_), nMemoryBudget(0), dTruncatedMass(.0), pCache(nullptr) {
+    if (vDamageDice.empty())
+        throw std::string{"AttackPipeline needs at least one damage die."};
+}
+
+std::shared_ptr<TabulatedObject> AttackPipeline::tabulate(const std::shared_ptr<StochasticObject>& pObject) {
+    if (nMemoryBudget>0) {
+        StreamingTabulator tabulator(dEpsilon, nMemoryBudget);
+        auto pTable = tabulator.tabulate(pObject);
+        dTruncatedMass += tabulator.getTruncatedMass();
+        return pTable;
+    }
+    ParallelTabulator tabulator(dEpsilon);
+    if (pCache)
+        return pCache->getTabulated(*pObject, dEpsilon, [&](){return tabulator.tabulate(pObject);});
+    return tabulator.tabulate(pObject);
+}
+
+std::shared_ptr<StochasticObject> AttackPipeline::getHitRaises(void) {
+    if (!pHitRaises) {
+        std::shared_ptr<StochasticObject> pAttackRoll = std::make_shared<AcingDie>(nAttackDieSides);
+        if (nWildDieSides>0)
+            pAttackRoll = std::make_shared<MaxConnector>(pAttackRoll, std::make_shared<AcingDie>(nWildDieSides));
+        auto pAttackModdedRoll = std::make_shared<FlatMod>(pAttackRoll, dMod);
+        pHitRaises = tabulate(std::make_shared<RaiseCounter>(pAttackModdedRoll));
+    }
+    return pHitRaises;
+}
+
+std::shared_ptr<StochasticObject> AttackPipeline::getDamage(void) {
+    if (!pDamage) {
+        // Add the dice pairwise, so the sums are independent subtrees that can be tabulated in parallel.
+        std::vector<std::shared_ptr<StochasticObject>> vSummands;
+        for (auto nDie: vDamageDice)
+            vSummands.push_back(std::make_shared<AcingDie>(nDie));
+        while (vSummands.size()>1) {
+            std::vector<std::shared_ptr<StochasticObject>> vSums;
+            for (std::size_t i=0; i+1<vSummands.size(); i+=2)
+                vSums.push_back(std::make_shared<AdderObject>(vSummands[i], vSummands[i+1]));
+            if (vSummands.size()%2==1)
+                vSums.push_back(vSummands.back());
+            vSummands = vSums;
+        }
+        pDamage = tabulate(vSummands.front());
+    }
+    return pDamage;
+}
+
+std::shared_ptr<StochasticObject> AttackPipeline::getRaiseDamage(void) {
+    if (!pRaiseDamage) {
+        if (nRaiseDieSides==0)
+            return getDamage();
+        pRaiseDamage = tabulate(std::make_shared<AdderObject>(getDamage(), std::make_shared<AcingDie>(nRaiseDieSides)));
+    }
+    return pRaiseDamage;
+}
+
+std::shared_ptr<StochasticObject> AttackPipeline::getWounds(void) {
+    auto pWoundCalculator = std::make_shared<WoundCalculatorObject>(getDamage(), dToughness, bShaken);
+    auto pWoundAfterRaiseCalculator = std::make_shared<WoundCalculatorObject>(getRaiseDamage(), dToughness, bShaken);
+
+    auto pBranchObject = std::make_shared<BranchObject>(getHitRaises(), pWoundAfterRaiseCalculator);
+    pBranchObject->vBranches.insert(Branch(std::make_shared<ConstantObject>(.0), 0.));
+    pBranchObject->vBranches.insert(Branch(pWoundCalculator, 1.));
+    return pBranchObject;
+}
+
+std::shared_ptr<JointDistribution> AttackPipeline::getJointDamage(void) {
+    auto pHits = std::static_pointer_cast<TabulatedObject>(getHitRaises());
+    auto pHitDamage = std::static_pointer_cast<TabulatedObject>(getDamage());
+    auto pRaiseHitDamage = std::static_pointer_cast<TabulatedObject>(getRaiseDamage());
+    auto nMaxLevel = pHits->getIntMaximum();
+    auto nMaxDamage = std::max(pHitDamage->getIntMaximum(), pRaiseHitDamage->getIntMaximum());
+    auto pJoint = std::make_shared<JointDistribution>(0, std::size_t(nMaxLevel)+1, 0, std::size_t(nMaxDamage)+1);
+    pJoint->addMass(0, 0, pHits->pmfAt(0));
+    for (std::int64_t nLevel=1; nLevel<=nMaxLevel; ++nLevel) {
+        double dLevel = pHits->pmfAt(nLevel);
+        auto &damage = nLevel==1 ? *pHitDamage : *pRaiseHitDamage;
+        for (auto nDamage=damage.getIntMinimum(); nDamage<=damage.getIntMaximum(); ++nDamage)
+            pJoint->addMass(nLevel, nDamage, dLevel*damage.pmfAt(nDamage));
+    }
+    return pJoint;
+}
+
+std::shared_ptr<JointDistribution> AttackPipeline::getJointWounds(void) {
+    auto nToughness = std::int64_t(dToughness);
+    bool bTargetShaken = bShaken;
+    if (double(nToughness)!=dToughness)
+        throw std::string{"Toughness must be an integer."};
+    return getJointDamage()->mapColumns([nToughness, bTargetShaken](std::int64_t nDamage){
+        return WoundCalculatorObject::woundsFromDamage(nDamage, nToughness, bTargetShaken);
+    });
+}
+
+void AttackPipeline::setAttackDice(unsigned int nAttackDieSides_, unsigned int nWildDieSides_) {
+    nAttackDieSides = nAttackDieSides_;
+    nWildDieSides = nWildDieSides_;
+    pHitRaises.reset();
+}
+
+void AttackPipeline::setMod(double dMod_) {
+    dMod = dMod_;
+    pHitRaises.reset();
+}
+
+void AttackPipeline::setDamageDice(const std::vector<unsigned int>& vDamageDice_) {
+    if (vDamageDice_.empty())
+        throw std::string{"AttackPipeline needs at least one damage die."};
+    vDamageDice = vDamageDice_;
+    pDamage.reset();
+    pRaiseDamage.reset();
+}
+
+void AttackPipeline::setRaiseDieSides(unsigned int nRaiseDieSides_) {
+    nRaiseDieSides = nRaiseDieSides_;
+    pRaiseDamage.reset();
+}
+
+void AttackPipeline::setMemoryBudget(std::size_t nMemoryBudget_) {
+    nMemoryBudget = nMemoryBudget_;
+    dTruncatedMass = .0;
+    pHitRaises.reset();
+    pDamage.reset();
+    pRaiseDamage.reset();
+}
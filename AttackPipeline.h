@@ -0,0 +1,97 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __ATTACKPIPELINE_H__
+#define __ATTACKPIPELINE_H__
+
+#include <memory>
+#include <vector>
+
+#include "StochasticObject.h"
+#include "TabulatedObject.h"
+#include "JointDistribution.h"
+#include "DistributionCache.h"
+
+// Attack roll (trait die and Wild Die against TN 4) followed by a damage roll against a target.
+// The number of hits/raises and the damage totals are tabulated once and reused until the dice
+// or modifier change, so varying only the target's toughness or shaken state is cheap.
+class AttackPipeline {
+    private:
+        unsigned int nAttackDieSides;
+        unsigned int nWildDieSides;
+        double dMod;
+        std::vector<unsigned int> vDamageDice;
+        unsigned int nRaiseDieSides;
+        double dToughness;
+        bool bShaken;
+        double dEpsilon;
+        std::size_t nMemoryBudget;
+        double dTruncatedMass;
+
+        std::shared_ptr<TabulatedObject> pHitRaises;
+        std::shared_ptr<TabulatedObject> pDamage;
+        std::shared_ptr<TabulatedObject> pRaiseDamage;
+        std::shared_ptr<DistributionCache> pCache;
+
+        std::shared_ptr<TabulatedObject> tabulate(const std::shared_ptr<StochasticObject>& pObject);
+    public:
+        // nWildDieSides_ = 0 means the attacker is an Extra and rolls no Wild Die.
+        AttackPipeline(unsigned int nAttackDieSides_, unsigned int nWildDieSides_, double dMod_,
+                       const std::vector<unsigned int>& vDamageDice_, unsigned int nRaiseDieSides_,
+                       double dToughness_, bool bShaken_, double dEpsilon_=1e-9);
+        ~AttackPipeline(void) = default;
+
+        // 0: miss, 1: hit, 2: hit with raise, ...
+        std::shared_ptr<StochasticObject> getHitRaises(void);
+        std::shared_ptr<StochasticObject> getDamage(void);
+        std::shared_ptr<StochasticObject> getRaiseDamage(void);
+        // Number of wounds caused, as in WoundCalculatorObject.
+        std::shared_ptr<StochasticObject> getWounds(void);
+        // Joint distributions of (hit/raise level as in getHitRaises, damage or wounds). A miss deals 0 damage.
+        std::shared_ptr<JointDistribution> getJointDamage(void);
+        std::shared_ptr<JointDistribution> getJointWounds(void);
+
+        unsigned int getAttackDieSides(void) const {return nAttackDieSides;};
+        unsigned int getWildDieSides(void) const {return nWildDieSides;};
+        void setAttackDice(unsigned int nAttackDieSides_, unsigned int nWildDieSides_);
+
+        double getMod(void) const {return dMod;};
+        void setMod(double dMod_);
+
+        const std::vector<unsigned int>& getDamageDice(void) const {return vDamageDice;};
+        void setDamageDice(const std::vector<unsigned int>& vDamageDice_);
+
+        unsigned int getRaiseDieSides(void) const {return nRaiseDieSides;};
+        void setRaiseDieSides(unsigned int nRaiseDieSides_);
+
+        double getToughness(void) const {return dToughness;};
+        void setToughness(double dToughness_) {dToughness=dToughness_;};
+
+        bool isShaken(void) const {return bShaken;};
+        void setShaken(bool bShaken_) {bShaken=bShaken_;};
+
+        // Tabulations are looked up in and added to pCache_ (may be nullptr).
+        void setCache(const std::shared_ptr<DistributionCache>& pCache_) {pCache=pCache_;};
+        // With a nonzero budget (in bytes) every tabulation is done by a StreamingTabulator instead,
+        // without the cache, since the tables may be truncated to fit.
+        std::size_t getMemoryBudget(void) const {return nMemoryBudget;};
+        void setMemoryBudget(std::size_t nMemoryBudget_);
+        // Probability mass cut off to fit the budget, added up over all tabulations since it was set.
+        double getTruncatedMass(void) const {return dTruncatedMass;};
+};
+
+#endif
@@ -0,0 +1,266 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <thread>
+#include <tuple>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#include "BatchProcessor.h"
+#include "BlockingQueue.h"
+#include "JsonObject.h"
+#include "SWTraitRoll.h"
+
+namespace {
+    struct Chunk {
+        std::uint64_t nSequence;
+        std::vector<BatchProcessor::Result> vResults;
+    };
+
+    void appendNumber(std::string& sOutput, double dValue) {
+        char buffer[32];
+#ifdef __cpp_lib_to_chars
+        // Formatting is the most expensive stage; to_chars is several times faster than snprintf.
+        auto result = std::to_chars(buffer, buffer+sizeof(buffer), dValue, std::chars_format::general, 10);
+        sOutput.append(buffer, result.ptr);
+#else
+        std::snprintf(buffer, sizeof(buffer), "%.10g", dValue);
+        sOutput += buffer;
+#endif
+    }
+}
+
+BatchProcessor::BatchProcessor(Format format_, std::size_t nWorkers_, std::size_t nChunkSize_): format(format_),
+        nWorkers(nWorkers_>0?nWorkers_:std::max(1u, std::thread::hardware_concurrency())), nChunkSize(std::max<std::size_t>(nChunkSize_, 1)) {
+}
+
+BatchProcessor::Query BatchProcessor::parseQuery(const std::string& sLine) {
+    Query query{0, 0, 0, 6, 0, ""};
+    std::vector<long long> vValues;
+    const char* pText = sLine.c_str();
+    while (true) {
+        while (*pText==' ' || *pText=='\t' || *pText=='\r' || *pText==',')
+            ++pText;
+        if (*pText=='\0')
+            break;
+        char* pEnd = nullptr;
+        long long nValue = std::strtoll(pText, &pEnd, 10);
+        if (pEnd==pText || (*pEnd!='\0' && *pEnd!=' ' && *pEnd!='\t' && *pEnd!='\r' && *pEnd!=',')) {
+            const char* pFieldEnd = pText;
+            while (*pFieldEnd!='\0' && *pFieldEnd!=' ' && *pFieldEnd!='\t' && *pFieldEnd!='\r' && *pFieldEnd!=',')
+                ++pFieldEnd;
+            query.sError = "Not an integer: "+std::string(pText, pFieldEnd);
+            return query;
+        }
+        vValues.push_back(nValue);
+        pText = pEnd;
+    }
+    if (vValues.empty() || vValues.size()>4) {
+        query.sError = "Expected TraitDie [Modifier] [WildDie] [Rerolls]";
+        return query;
+    }
+    if (vValues[0]<=1 || vValues[0]>1000 || (vValues.size()>2 && (vValues[2]<=1 || vValues[2]>1000))) {
+        query.sError = "Trait and Wild Die need between 2 and 1000 sides.";
+        return query;
+    }
+    if (vValues.size()>1 && (vValues[1]<-1000 || vValues[1]>1000)) {
+        query.sError = "Modifier out of range.";
+        return query;
+    }
+    if (vValues.size()>3 && (vValues[3]<0 || vValues[3]>100)) {
+        query.sError = "Rerolls must be between 0 and 100.";
+        return query;
+    }
+    query.nTraitDie = (unsigned int)vValues[0];
+    if (vValues.size()>1)
+        query.nMod = (int)vValues[1];
+    if (vValues.size()>2)
+        query.nWildDie = (unsigned int)vValues[2];
+    if (vValues.size()>3)
+        query.nRerolls = (unsigned int)vValues[3];
+    return query;
+}
+
+std::string BatchProcessor::getHeader(Format format_) {
+    if (format_==Format::CSV)
+        return "line,trait,modifier,wild,rerolls,crit_fail,fail,success,raise_1,raise_2,raise_3,raise_4_or_more,mean,error";
+    return "";
+}
+
+void BatchProcessor::computeResult(Result& result) const {
+    try {
+        SWTraitRoll traitRoll(result.query.nTraitDie, result.query.nWildDie, result.query.nMod, result.query.nRerolls);
+        result.vProbabilities.clear();
+        result.vProbabilities.push_back(traitRoll.cdfAt(-1));
+        for (std::int64_t n=0; n<=4; ++n)
+            result.vProbabilities.push_back(traitRoll.pmfAt(n));
+        result.vProbabilities.push_back(1.-traitRoll.cdfAt(4));
+        result.dMean = traitRoll.mean();
+    } catch (const std::string& sError) {
+        result.query.sError = sError;
+    }
+}
+
+void BatchProcessor::formatResult(const Result& result, std::string& sOutput) const {
+    const Query& query = result.query;
+    bool bFailed = !query.sError.empty();
+    if (format==Format::CSV) {
+        sOutput += std::to_string(query.nLine);
+        if (bFailed) {
+            sOutput += ",,,,,,,,,,,,,\"";
+            for (auto c: query.sError)
+                sOutput += (c=='"' ? std::string{"\"\""} : std::string{c});
+            sOutput += "\"\n";
+            return;
+        }
+        for (long long nValue: {(long long)query.nTraitDie, (long long)query.nMod, (long long)query.nWildDie, (long long)query.nRerolls}) {
+            sOutput += ",";
+            sOutput += std::to_string(nValue);
+        }
+        for (auto dP: result.vProbabilities) {
+            sOutput += ",";
+            appendNumber(sOutput, dP);
+        }
+        sOutput += ",";
+        appendNumber(sOutput, result.dMean);
+        sOutput += ",\n";
+        return;
+    }
+    sOutput += "{\"line\":"+std::to_string(query.nLine);
+    if (bFailed) {
+        sOutput += ",\"error\":"+JsonObject::quote(query.sError)+"}\n";
+        return;
+    }
+    sOutput += ",\"trait\":";
+    sOutput += std::to_string(query.nTraitDie);
+    sOutput += ",\"modifier\":";
+    sOutput += std::to_string(query.nMod);
+    sOutput += ",\"wild\":";
+    sOutput += std::to_string(query.nWildDie);
+    sOutput += ",\"rerolls\":";
+    sOutput += std::to_string(query.nRerolls);
+    sOutput += ",\"p\":[";
+    for (std::size_t i=0; i<result.vProbabilities.size(); ++i) {
+        if (i>0)
+            sOutput += ",";
+        appendNumber(sOutput, result.vProbabilities[i]);
+    }
+    sOutput += "],\"mean\":";
+    appendNumber(sOutput, result.dMean);
+    sOutput += "}\n";
+}
+
+std::uint64_t BatchProcessor::run(std::istream& input, std::ostream& output) const {
+    // A few chunks in flight per worker keep every stage busy without buffering the whole input.
+    BlockingQueue<Chunk> parsedChunks(2*nWorkers+2);
+    BlockingQueue<Chunk> computedChunks(2*nWorkers+2);
+
+    std::thread reader([this, &input, &parsedChunks](){
+        Chunk chunk{0, {}};
+        std::uint64_t nLine = 0;
+        std::string sLine;
+        while (std::getline(input, sLine)) {
+            ++nLine;
+            auto nStart = sLine.find_first_not_of(" \t\r");
+            if (nStart==std::string::npos || sLine[nStart]=='#')
+                continue;
+            Result result;
+            result.query = parseQuery(sLine);
+            result.query.nLine = nLine;
+            result.dMean = .0;
+            chunk.vResults.push_back(std::move(result));
+            // Hand over early when no more input is waiting, so interactive callers get their answers.
+            if (chunk.vResults.size()>=nChunkSize || input.rdbuf()->in_avail()<=0) {
+                std::uint64_t nNext = chunk.nSequence+1;
+                parsedChunks.push(std::move(chunk));
+                chunk = Chunk{nNext, {}};
+            }
+        }
+        if (!chunk.vResults.empty())
+            parsedChunks.push(std::move(chunk));
+        parsedChunks.close();
+    });
+
+    std::atomic<std::size_t> nRunningWorkers(nWorkers);
+    std::vector<std::thread> vWorkers;
+    for (std::size_t i=0; i<nWorkers; ++i) {
+        vWorkers.emplace_back([this, &parsedChunks, &computedChunks, &nRunningWorkers](){
+            // Scripts tend to repeat the same few rolls; remember their answers.
+            std::map<std::tuple<unsigned int, int, unsigned int, unsigned int>, Result> mKnown;
+            Chunk chunk;
+            while (parsedChunks.pop(chunk)) {
+                for (auto &result: chunk.vResults) {
+                    if (!result.query.sError.empty())
+                        continue;
+                    auto key = std::make_tuple(result.query.nTraitDie, result.query.nMod, result.query.nWildDie, result.query.nRerolls);
+                    auto known = mKnown.find(key);
+                    if (known!=mKnown.end()) {
+                        result.vProbabilities = known->second.vProbabilities;
+                        result.dMean = known->second.dMean;
+                        result.query.sError = known->second.query.sError;
+                        continue;
+                    }
+                    computeResult(result);
+                    if (mKnown.size()>=nMaxKnownRolls)
+                        mKnown.clear();
+                    mKnown[key] = result;
+                }
+                computedChunks.push(std::move(chunk));
+            }
+            if (--nRunningWorkers==0)
+                computedChunks.close();
+        });
+    }
+
+    // Chunks finish out of order; hold them back until all earlier ones are written.
+    std::map<std::uint64_t, Chunk> mWaiting;
+    std::uint64_t nNextSequence = 0;
+    std::uint64_t nRows = 0;
+    std::string sOutput;
+    std::string sHeader = getHeader(format);
+    if (!sHeader.empty())
+        output << sHeader << "\n";
+    Chunk chunk;
+    while (computedChunks.pop(chunk)) {
+        mWaiting[chunk.nSequence] = std::move(chunk);
+        for (auto next=mWaiting.find(nNextSequence); next!=mWaiting.end(); next=mWaiting.find(nNextSequence)) {
+            sOutput.clear();
+            for (auto &result: next->second.vResults)
+                formatResult(result, sOutput);
+            output << sOutput;
+            nRows += next->second.vResults.size();
+            mWaiting.erase(next);
+            ++nNextSequence;
+        }
+        if (computedChunks.empty())
+            output.flush();
+    }
+    reader.join();
+    for (auto &worker: vWorkers)
+        worker.join();
+    output.flush();
+    return nRows;
+}
@@ -0,0 +1,74 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __BATCHPROCESSOR_H__
+#define __BATCHPROCESSOR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Answers one trait roll per input line ("TraitDie [Modifier] [WildDie] [Rerolls]", separated by
+// blanks or commas) with one CSV or JSON line. Reading and parsing, computing and formatting run as
+// pipelined stages: a reader thread, nWorkers compute threads and the calling thread, which writes
+// the results in input order. Lines are passed between the stages in chunks to keep locking cheap.
+// Empty lines and lines starting with '#' are skipped; malformed lines produce a row with an error.
+//
+// CSV columns: line,trait,modifier,wild,rerolls,crit_fail,fail,success,raise_1,raise_2,raise_3,raise_4_or_more,mean,error
+// JSON: {"line":1,"trait":8,"modifier":0,"wild":6,"rerolls":0,"p":[crit_fail,...,raise_4_or_more],"mean":...}
+//       or {"line":1,"error":"..."}
+class BatchProcessor {
+    public:
+        enum class Format {CSV, JSON};
+        struct Query {
+            std::uint64_t nLine;
+            unsigned int nTraitDie;
+            int nMod;
+            unsigned int nWildDie;
+            unsigned int nRerolls;
+            std::string sError;
+        };
+        struct Result {
+            Query query;
+            std::vector<double> vProbabilities;
+            double dMean;
+        };
+    private:
+        Format format;
+        std::size_t nWorkers;
+        std::size_t nChunkSize;
+        static const std::size_t nMaxKnownRolls = 65536;
+
+        void computeResult(Result& result) const;
+        void formatResult(const Result& result, std::string& sOutput) const;
+    public:
+        // nWorkers_ = 0 uses one compute thread per hardware thread.
+        BatchProcessor(Format format_=Format::CSV, std::size_t nWorkers_=0, std::size_t nChunkSize_=256);
+        ~BatchProcessor(void) = default;
+
+        // Processes input until it ends and returns the number of rows written.
+        std::uint64_t run(std::istream& input, std::ostream& output) const;
+
+        // Fills everything but nLine; sets sError instead of throwing.
+        static Query parseQuery(const std::string& sLine);
+        static std::string getHeader(Format format_);
+};
+
+#endif
@@ -0,0 +1,77 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __BLOCKINGQUEUE_H__
+#define __BLOCKINGQUEUE_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Bounded FIFO connecting the stages of a pipeline. push blocks while the queue is full, pop blocks
+// while it is empty. Once close() has been called, pop drains the remaining items and then returns false.
+template<typename T>
+class BlockingQueue {
+    private:
+        std::deque<T> qItems;
+        std::size_t nCapacity;
+        bool bClosed;
+        std::mutex mutex;
+        std::condition_variable cvNotEmpty;
+        std::condition_variable cvNotFull;
+    public:
+        BlockingQueue(std::size_t nCapacity_): nCapacity(nCapacity_>0?nCapacity_:1), bClosed(false) {};
+        ~BlockingQueue(void) = default;
+        BlockingQueue(const BlockingQueue&) = delete;
+        BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+        void push(T item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cvNotFull.wait(lock, [this](){return qItems.size()<nCapacity || bClosed;});
+            if (bClosed)
+                return;
+            qItems.push_back(std::move(item));
+            cvNotEmpty.notify_one();
+        };
+
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            cvNotEmpty.wait(lock, [this](){return !qItems.empty() || bClosed;});
+            if (qItems.empty())
+                return false;
+            item = std::move(qItems.front());
+            qItems.pop_front();
+            cvNotFull.notify_one();
+            return true;
+        };
+
+        bool empty(void) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return qItems.empty();
+        };
+
+        // Wakes all waiting threads; items pushed afterwards are dropped.
+        void close(void) {
+            std::lock_guard<std::mutex> lock(mutex);
+            bClosed = true;
+            cvNotEmpty.notify_all();
+            cvNotFull.notify_all();
+        };
+};
+
+#endif
@@ -15,22 +15,39 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
-#include <iostream>
-#include <limits>
 #include <algorithm>
+#include <cmath>
 
 #include "BranchObject.h"
+#include "TabulatedObject.h"
+#include "ImportanceSampler.h"
 
 Branch::Branch(const std::shared_ptr<StochasticObject>& pResult_, double dRangeLower_):
         pResult(pResult_), dRangeLower(dRangeLower_)
 {}
 
-double Branch::distributionFunction(double dX) const {
-    return pResult->distributionFunction(dX);
+double Branch::cdfAt(std::int64_t n) const {
+    return pResult->cdfAt(n);
 }
 
-double Branch::getMinimum(void) const {
-    return pResult->getMinimum();
+std::int64_t Branch::getIntMinimum(void) const {
+    return pResult->getIntMinimum();
+}
+
+std::int64_t Branch::getIntMaximum(void) const {
+    return pResult->getIntMaximum();
+}
+
+double Branch::mean(void) const {
+    return pResult->mean();
+}
+
+double Branch::variance(void) const {
+    return pResult->variance();
+}
+
+std::int64_t Branch::sample(ImportanceSampler& sampler) const {
+    return pResult->sample(sampler);
 }
 
 bool Branch::operator<(const Branch& other) const {
@@ -41,34 +58,140 @@ double Branch::getRangeLower(void) const {
     return dRangeLower;
 }
 
+std::string Branch::getDescription(void) const {
+    return "Branch("+describeNumber(dRangeLower)+","+pResult->getDescription()+")";
+}
+
 BranchObject::BranchObject(const std::shared_ptr<StochasticObject>& pDecider_,
                            const std::shared_ptr<StochasticObject>& pDefault_) : 
     pDecider(pDecider_), pDefault(pDefault_), vBranches({}) {}
 
-double BranchObject::distributionFunction(double dX) const {
-    //std::cout << "dX"<<dX<<std::endl;
+double BranchObject::cdfAt(std::int64_t n) const {
     double dProbability = .0;
-    auto pLower = .0;//pDecider->distributionFunction(lastBoundary);
-    double coveredPSpace = .0;
+    double pLower = .0;
     for (auto &b: vBranches) {
-        double newBoundary = b.getRangeLower();
-        auto pUpper = pDecider->distributionFunction(newBoundary);
- //std::cout  << "pUpper: "<<pUpper<<" pLower: "<<pLower<<" boundary:"<<newBoundary<< " dF: "<<b.distributionFunction(dX)<<std::endl;
-        dProbability += (pUpper-pLower)*b.distributionFunction(dX);
-        coveredPSpace += (pUpper-pLower);
+        auto pUpper = pDecider->distributionFunction(b.getRangeLower());
+        dProbability += (pUpper-pLower)*b.cdfAt(n);
         pLower = pUpper;
     }
-//    std::cout << "Covered P Space: "<< 1.-coveredPSpace <<  " dF: "<<pDefault->distributionFunction(dX)<<std::endl;
-
-    dProbability += (1.-coveredPSpace)*pDefault->distributionFunction(dX);
+    dProbability += (1.-pLower)*pDefault->cdfAt(n);
     return dProbability;
 }
 
-double BranchObject::getMinimum(void) const {
-    double dMinimum = std::numeric_limits<double>::infinity();
+// Mixture of the branches: E[X] = sum w*m and Var[X] = sum w*(v+m^2) - E[X]^2.
+double BranchObject::mean(void) const {
+    double dMean = .0;
+    double pLower = .0;
+    for (auto &b: vBranches) {
+        auto pUpper = pDecider->distributionFunction(b.getRangeLower());
+        if (pUpper>pLower)
+            dMean += (pUpper-pLower)*b.mean();
+        pLower = pUpper;
+    }
+    if (pLower<1.)
+        dMean += (1.-pLower)*pDefault->mean();
+    return dMean;
+}
+
+double BranchObject::variance(void) const {
+    double dMean = .0, dSecond = .0;
+    double pLower = .0;
+    auto addComponent = [&](double dWeight, const StochasticObject& component) {
+        if (dWeight<=.0)
+            return;
+        double dComponentMean = component.mean();
+        dMean += dWeight*dComponentMean;
+        dSecond += dWeight*(component.variance()+dComponentMean*dComponentMean);
+    };
+    for (auto &b: vBranches) {
+        auto pUpper = pDecider->distributionFunction(b.getRangeLower());
+        addComponent(pUpper-pLower, b);
+        pLower = pUpper;
+    }
+    addComponent(1.-pLower, *pDefault);
+    return std::max(.0, dSecond-dMean*dMean);
+}
+
+std::int64_t BranchObject::sample(ImportanceSampler& sampler) const {
+    // The first branch whose boundary the decider does not exceed, as in cdfAt.
+    double dDecision = double(pDecider->sample(sampler));
+    for (auto &b: vBranches)
+        if (dDecision<=b.getRangeLower())
+            return b.sample(sampler);
+    return pDefault->sample(sampler);
+}
+
+std::int64_t BranchObject::getIntMinimum(void) const {
+    std::int64_t nMinimum = pDefault->getIntMinimum();
     for (auto &b: vBranches) {
-        dMinimum = std::min(dMinimum, b.getMinimum());
+        nMinimum = std::min(nMinimum, b.getIntMinimum());
+    }
+    return nMinimum;
+}
+
+std::int64_t BranchObject::getIntMaximum(void) const {
+    std::int64_t nMaximum = pDefault->getIntMaximum();
+    for (auto &b: vBranches) {
+        nMaximum = std::max(nMaximum, b.getIntMaximum());
+    }
+    return nMaximum;
+}
+
+std::string BranchObject::getDescription(void) const {
+    std::string sDescription = "BranchObject("+pDecider->getDescription()+","+pDefault->getDescription();
+    for (auto &b: vBranches)
+        sDescription += ","+b.getDescription();
+    return sDescription+")";
+}
+
+std::vector<std::shared_ptr<StochasticObject>> Branch::getChildren(void) const {
+    return {pResult};
+}
+
+std::shared_ptr<StochasticObject> Branch::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<Branch>(vChildren.at(0), dRangeLower);
+}
+
+std::vector<std::shared_ptr<StochasticObject>> BranchObject::getChildren(void) const {
+    std::vector<std::shared_ptr<StochasticObject>> vChildren{pDecider, pDefault};
+    for (auto &b: vBranches)
+        vChildren.push_back(b.getResult());
+    return vChildren;
+}
+
+std::shared_ptr<StochasticObject> BranchObject::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    auto pBranchObject = std::make_shared<BranchObject>(vChildren.at(0), vChildren.at(1));
+    std::size_t i = 2;
+    for (auto &b: vBranches)
+        pBranchObject->vBranches.insert(Branch(vChildren.at(i++), b.getRangeLower()));
+    return pBranchObject;
+}
+
+std::shared_ptr<TabulatedObject> BranchObject::tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const {
+    // Same weights as in cdfAt, taken from the tabulated decider.
+    std::vector<std::pair<double, const TabulatedObject*>> vComponents;
+    double pLower = .0;
+    std::size_t i = 2;
+    for (auto &b: vBranches) {
+        auto pUpper = vChildren.at(0)->distributionFunction(b.getRangeLower());
+        vComponents.emplace_back(pUpper-pLower, vChildren.at(i++).get());
+        pLower = pUpper;
+    }
+    vComponents.emplace_back(1.-pLower, vChildren.at(1).get());
+    return TabulatedObject::mix(vComponents, dEpsilon);
+}
+
+StochasticObject::CostEstimate BranchObject::estimateCost(const std::vector<CostEstimate>& vChildren, double) const {
+    // Every branch looks the decider up once per query.
+    CostEstimate estimate{.0, 1., .0, .0};
+    double dPoints = .0;
+    for (std::size_t i=0; i<vChildren.size(); ++i) {
+        if (i>0)
+            estimate.dSupport = std::max(estimate.dSupport, vChildren[i].dSupport);
+        estimate.dQueryCost += vChildren[i].dQueryCost*(i==0 ? double(vBranches.size()) : 1.);
+        estimate.dSetupCost += vChildren[i].dSetupCost;
+        dPoints += i>0 ? vChildren[i].dSupport : .0;
     }
-    dMinimum = std::min(dMinimum, pDefault->getMinimum());
-    return dMinimum;
+    estimate.dCombineCost = dPoints*(1.+std::log2(dPoints+1.));
+    return estimate;
 }
@@ -29,10 +29,18 @@ class Branch: public StochasticObject {
     public:
         Branch(const std::shared_ptr<StochasticObject>& pResult_, double dRangeLower_);
         virtual ~Branch(void) = default;
-        virtual double distributionFunction(double) const;
-        virtual double getMinimum(void) const;
+        virtual double cdfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
 
         double getRangeLower(void) const;
+        const std::shared_ptr<StochasticObject>& getResult(void) const {return pResult;};
         bool operator<(const Branch& other) const;
 };
 
@@ -43,8 +51,17 @@ class BranchObject: public StochasticObject {
     public:
         BranchObject(const std::shared_ptr<StochasticObject>& pDecider_, const std::shared_ptr<StochasticObject>& pDefault_);
         virtual ~BranchObject(void) = default;
-        virtual double distributionFunction(double) const;
-        virtual double getMinimum(void) const;
+        virtual double cdfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+        virtual std::shared_ptr<TabulatedObject> tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const;
+        virtual CostEstimate estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const;
 
         std::set<Branch> vBranches;
 };
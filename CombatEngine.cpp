@@ -0,0 +1,116 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <limits>
+#include <algorithm>
+
+#include "CombatEngine.h"
+
+CombatEngine::CombatEngine(unsigned int nMaxWounds_): nMaxWounds(nMaxWounds_), dUnshakeProbability(.0),
+        nInitialWounds(0), bInitiallyShaken(false), vAttackTransitions({}) {
+    buildUnshakeTransition();
+}
+
+std::size_t CombatEngine::getStateIndex(unsigned int nWounds, bool bShaken) const {
+    if (nWounds>nMaxWounds)
+        return getIncapacitatedIndex();
+    return 2*nWounds + (bShaken?1:0);
+}
+
+void CombatEngine::addAttack(const std::shared_ptr<StochasticObject>& pWoundsVsUnshaken, const std::shared_ptr<StochasticObject>& pWoundsVsShaken) {
+    std::map<std::pair<std::size_t,std::size_t>, double> mEntries;
+    double dNoEffect = pWoundsVsShaken->cdfAt(0);
+    for (unsigned int nWounds=0; nWounds<=nMaxWounds; ++nWounds) {
+        for (bool bShaken: {false, true}) {
+            auto nFrom = getStateIndex(nWounds, bShaken);
+            auto &pWounds = bShaken?pWoundsVsShaken:pWoundsVsUnshaken;
+            mEntries[{nFrom, nFrom}] += dNoEffect;
+            if (!bShaken) {
+                // Against an unshaken target the "no wound" outcome splits into "no effect" and "shaken".
+                double dShakenOnly = std::max(.0, pWounds->cdfAt(0)-dNoEffect);
+                mEntries[{getStateIndex(nWounds, true), nFrom}] += dShakenOnly;
+            }
+            double dLower = pWounds->cdfAt(0);
+            unsigned int nWoundsLeft = nMaxWounds-nWounds;
+            for (unsigned int k=1; k<=nWoundsLeft; ++k) {
+                double dUpper = pWounds->cdfAt(k);
+                mEntries[{getStateIndex(nWounds+k, true), nFrom}] += dUpper-dLower;
+                dLower = dUpper;
+            }
+            mEntries[{getIncapacitatedIndex(), nFrom}] += 1.-dLower;
+        }
+    }
+    mEntries[{getIncapacitatedIndex(), getIncapacitatedIndex()}] = 1.;
+    vAttackTransitions.emplace_back(getStateCount(), getStateCount(), mEntries);
+}
+
+void CombatEngine::buildUnshakeTransition(void) {
+    std::map<std::pair<std::size_t,std::size_t>, double> mEntries;
+    for (unsigned int nWounds=0; nWounds<=nMaxWounds; ++nWounds) {
+        mEntries[{getStateIndex(nWounds, false), getStateIndex(nWounds, false)}] = 1.;
+        mEntries[{getStateIndex(nWounds, false), getStateIndex(nWounds, true)}] = dUnshakeProbability;
+        mEntries[{getStateIndex(nWounds, true), getStateIndex(nWounds, true)}] = 1.-dUnshakeProbability;
+    }
+    mEntries[{getIncapacitatedIndex(), getIncapacitatedIndex()}] = 1.;
+    mUnshakeTransition = SparseMatrix(getStateCount(), getStateCount(), mEntries);
+}
+
+void CombatEngine::setUnshakeProbability(double dUnshakeProbability_) {
+    if (dUnshakeProbability_<.0 || dUnshakeProbability_>1.)
+        throw std::string{"Unshake probability must be between 0 and 1."};
+    dUnshakeProbability = dUnshakeProbability_;
+    buildUnshakeTransition();
+}
+
+void CombatEngine::setInitialState(unsigned int nWounds, bool bShaken) {
+    nInitialWounds = nWounds;
+    bInitiallyShaken = bShaken;
+}
+
+std::vector<double> CombatEngine::advanceRound(const std::vector<double>& vState) const {
+    auto vNext = mUnshakeTransition.multiply(vState);
+    for (auto &mTransition: vAttackTransitions)
+        vNext = mTransition.multiply(vNext);
+    return vNext;
+}
+
+std::vector<double> CombatEngine::getStateDistribution(unsigned int nRounds) const {
+    std::vector<double> vState(getStateCount(), .0);
+    vState[getStateIndex(nInitialWounds, bInitiallyShaken)] = 1.;
+    for (unsigned int i=0; i<nRounds; ++i)
+        vState = advanceRound(vState);
+    return vState;
+}
+
+double CombatEngine::getIncapacitationProbability(unsigned int nRounds) const {
+    return getStateDistribution(nRounds)[getIncapacitatedIndex()];
+}
+
+double CombatEngine::getExpectedRoundsUntilIncapacitated(double dEpsilon, unsigned int nMaxRounds) const {
+    // E[T] = sum over n>=0 of P(T>n)
+    std::vector<double> vState = getStateDistribution(0);
+    double dExpectation = .0;
+    for (unsigned int i=0; i<nMaxRounds; ++i) {
+        double dSurvival = 1.-vState[getIncapacitatedIndex()];
+        if (dSurvival<dEpsilon)
+            return dExpectation;
+        dExpectation += dSurvival;
+        vState = advanceRound(vState);
+    }
+    return std::numeric_limits<double>::infinity();
+}
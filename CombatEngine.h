@@ -0,0 +1,64 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __COMBATENGINE_H__
+#define __COMBATENGINE_H__
+
+#include <memory>
+#include <vector>
+
+#include "StochasticObject.h"
+#include "SparseMatrix.h"
+
+// Markov chain over the states of a single target (wounds, shaken, incapacitated).
+// Every round the target first tries to recover from being shaken, then all attacks
+// added with addAttack are resolved in order.
+class CombatEngine {
+    private:
+        unsigned int nMaxWounds;
+        double dUnshakeProbability;
+        unsigned int nInitialWounds;
+        bool bInitiallyShaken;
+        std::vector<SparseMatrix> vAttackTransitions;
+        SparseMatrix mUnshakeTransition;
+
+        void buildUnshakeTransition(void);
+    public:
+        // A target is incapacitated once it has more than nMaxWounds_ wounds (3 for Wild Cards, 0 for Extras).
+        CombatEngine(unsigned int nMaxWounds_=3);
+        ~CombatEngine(void) = default;
+
+        // Both objects give the number of wounds caused by the same attack, once against an
+        // unshaken and once against a shaken target (see WoundCalculatorObject).
+        void addAttack(const std::shared_ptr<StochasticObject>& pWoundsVsUnshaken, const std::shared_ptr<StochasticObject>& pWoundsVsShaken);
+
+        std::size_t getStateCount(void) const {return 2*(nMaxWounds+1)+1;};
+        std::size_t getStateIndex(unsigned int nWounds, bool bShaken) const;
+        std::size_t getIncapacitatedIndex(void) const {return 2*(nMaxWounds+1);};
+
+        std::vector<double> getStateDistribution(unsigned int nRounds) const;
+        std::vector<double> advanceRound(const std::vector<double>& vState) const;
+        double getIncapacitationProbability(unsigned int nRounds) const;
+        double getExpectedRoundsUntilIncapacitated(double dEpsilon=1e-9, unsigned int nMaxRounds=100000) const;
+
+        unsigned int getMaxWounds(void) const {return nMaxWounds;};
+        double getUnshakeProbability(void) const {return dUnshakeProbability;};
+        void setUnshakeProbability(double dUnshakeProbability_);
+        void setInitialState(unsigned int nWounds, bool bShaken);
+};
+
+#endif
@@ -22,20 +22,41 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 
 class ConstantObject: public StochasticObject {
     private:
-        double dResult;
+        std::int64_t nResult;
     public:
-        ConstantObject(double dResult_=0): dResult(dResult_) {};
+        ConstantObject(double dResult_=0): nResult(toInteger(dResult_, "ConstantObject result")) {};
         virtual ~ConstantObject(void) = default;
 
-        virtual double distributionFunction(double dX) const {
-            return (dX>=dResult?1.0:0.0);
+        virtual double cdfAt(std::int64_t n) const {
+            return (n>=nResult?1.0:0.0);
         };
-        virtual double getMinimum(void) const {
-            return dResult;
+        virtual double pmfAt(std::int64_t n) const {
+            return (n==nResult?1.0:0.0);
+        };
+        virtual std::int64_t getIntMinimum(void) const {
+            return nResult;
+        };
+        virtual std::int64_t getIntMaximum(void) const {
+            return nResult;
+        };
+        virtual double mean(void) const {
+            return double(nResult);
+        };
+        virtual double variance(void) const {
+            return .0;
+        };
+        virtual std::int64_t sample(ImportanceSampler&) const {
+            return nResult;
+        };
+        virtual std::string getDescription(void) const {
+            return "Constant("+std::to_string(nResult)+")";
+        };
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>&) const {
+            return std::make_shared<ConstantObject>(*this);
         };
 
-        void setResult(double dResult_) {dResult=dResult_;};
-        double getResult(void) {return dResult;};
+        void setResult(double dResult_) {nResult=toInteger(dResult_, "ConstantObject result");};
+        double getResult(void) const {return double(nResult);};
 };
 
 #endif
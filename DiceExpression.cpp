@@ -0,0 +1,282 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include "AcingDie.h"
+#include "AdderObject.h"
+#include "ConstantObject.h"
+#include "FlatMod.h"
+#include "GroupRoll.h"
+#include "MaxConnector.h"
+#include "OpposedRoll.h"
+#include "RaiseCounter.h"
+#include "WoundCalculatorObject.h"
+
+#include "DiceExpression.h"
+
+DiceExpression::DiceExpression(const std::string& sExpression_): sExpression(sExpression_), nPos(0), nDepth(0), pRoot(nullptr) {
+    pRoot = materialize(parseSum());
+    skipWhitespace();
+    if (nPos<sExpression.size())
+        fail("Unexpected '"+std::string(1, sExpression[nPos])+"'");
+}
+
+void DiceExpression::fail(const std::string& sMessage) const {
+    throw sMessage+" at position "+std::to_string(nPos)+" of \""+sExpression+"\".";
+}
+
+void DiceExpression::skipWhitespace(void) {
+    while (nPos<sExpression.size() && std::isspace((unsigned char)sExpression[nPos]))
+        ++nPos;
+}
+
+bool DiceExpression::consume(char c) {
+    skipWhitespace();
+    if (nPos<sExpression.size() && sExpression[nPos]==c) {
+        ++nPos;
+        return true;
+    }
+    return false;
+}
+
+void DiceExpression::expect(char c) {
+    if (!consume(c))
+        fail(std::string{"Expected '"}+c+"'");
+}
+
+std::string DiceExpression::parseIdentifier(void) {
+    skipWhitespace();
+    std::size_t nStart = nPos;
+    while (nPos<sExpression.size() && (std::isalnum((unsigned char)sExpression[nPos]) || sExpression[nPos]=='_'))
+        ++nPos;
+    if (nStart==nPos)
+        fail("Expected a name");
+    return sExpression.substr(nStart, nPos-nStart);
+}
+
+DiceExpression::Scalar DiceExpression::parseScalar(void) {
+    skipWhitespace();
+    Scalar scalar{.0, ""};
+    if (consume('$')) {
+        scalar.sParameter = parseIdentifier();
+        sParameters.insert(scalar.sParameter);
+        return scalar;
+    }
+    bool bNegative = consume('-');
+    skipWhitespace();
+    const char* pStart = sExpression.c_str()+nPos;
+    char* pEnd = nullptr;
+    scalar.dValue = std::strtod(pStart, &pEnd);
+    if (pEnd==pStart || !std::isdigit((unsigned char)*pStart))
+        fail("Expected a number or $parameter");
+    nPos += pEnd-pStart;
+    if (bNegative)
+        scalar.dValue = -scalar.dValue;
+    return scalar;
+}
+
+DiceExpression::Term DiceExpression::parseSum(void) {
+    // Every parenthesis and call argument is a nested sum.
+    if (++nDepth>nMaxDepth)
+        fail("Expression nested too deeply");
+    Term sum{nullptr, .0, {}};
+    double dSign = 1.;
+    if (consume('-'))
+        dSign = -1.;
+    else
+        consume('+');
+    while (true) {
+        Term term = parseTerm();
+        if (term.pObject) {
+            if (dSign<0.)
+                fail("Dice cannot be subtracted");
+            sum.pObject = sum.pObject?std::make_shared<AdderObject>(sum.pObject, term.pObject):term.pObject;
+        }
+        sum.dConstant += dSign*term.dConstant;
+        for (auto &parameter: term.vParameters)
+            sum.vParameters.emplace_back(dSign*parameter.first, parameter.second);
+        if (consume('+'))
+            dSign = 1.;
+        else if (consume('-'))
+            dSign = -1.;
+        else
+            break;
+    }
+    --nDepth;
+    return sum;
+}
+
+DiceExpression::Term DiceExpression::parseTerm(void) {
+    skipWhitespace();
+    if (nPos>=sExpression.size())
+        fail("Unexpected end of expression");
+    char c = sExpression[nPos];
+    if (c=='(') {
+        ++nPos;
+        Term term = parseSum();
+        expect(')');
+        return term;
+    }
+    if (std::isdigit((unsigned char)c) || c=='$') {
+        Scalar scalar = parseScalar();
+        if (scalar.sParameter.empty())
+            return Term{nullptr, scalar.dValue, {}};
+        return Term{nullptr, .0, {{1., scalar.sParameter}}};
+    }
+    if ((c=='d' || c=='D') && nPos+1<sExpression.size() && (std::isdigit((unsigned char)sExpression[nPos+1]) || sExpression[nPos+1]=='$')) {
+        ++nPos;
+        Scalar sides = parseScalar();
+        if (!consume('!'))
+            fail("Only exploding dice are supported, write d"+(sides.sParameter.empty()?std::to_string(int(sides.dValue)):"$"+sides.sParameter)+"!");
+        if (!sides.sParameter.empty()) {
+            auto pDie = std::make_shared<AcingDie>(6);
+            vBinders.push_back([pDie, sides](const Bindings& bindings){
+                double dSides = lookup(bindings, sides.sParameter);
+                if (dSides<2. || dSides!=std::floor(dSides))
+                    throw std::string{"$"}+sides.sParameter+" must be an integer greater than 1 to be used as die.";
+                pDie->setSides((unsigned int)dSides);
+            });
+            return Term{pDie, .0, {}};
+        }
+        if (sides.dValue<2. || sides.dValue!=std::floor(sides.dValue))
+            fail("Dice need an integer number of sides greater than 1");
+        return Term{std::make_shared<AcingDie>((unsigned int)sides.dValue), .0, {}};
+    }
+    if (std::isalpha((unsigned char)c)) {
+        std::string sName = parseIdentifier();
+        expect('(');
+        Term term = parseCall(sName);
+        expect(')');
+        return term;
+    }
+    fail("Unexpected '"+std::string(1, c)+"'");
+}
+
+DiceExpression::Term DiceExpression::parseCall(const std::string& sName) {
+    if (sName=="max") {
+        auto pResult = materialize(parseSum());
+        while (consume(','))
+            pResult = std::make_shared<MaxConnector>(pResult, materialize(parseSum()));
+        return Term{pResult, .0, {}};
+    }
+    if (sName=="raises") {
+        return Term{std::make_shared<RaiseCounter>(materialize(parseSum())), .0, {}};
+    }
+    if (sName=="wounds") {
+        auto pDamage = materialize(parseSum());
+        Scalar toughness{.0, ""};
+        Scalar shaken{.0, ""};
+        bool bToughnessGiven = false;
+        while (consume(',')) {
+            std::string sArgument = parseIdentifier();
+            if (sArgument=="T" || sArgument=="toughness") {
+                expect('=');
+                toughness = parseScalar();
+                bToughnessGiven = true;
+            } else if (sArgument=="shaken") {
+                shaken.dValue = 1.;
+                if (consume('='))
+                    shaken = parseScalar();
+            } else {
+                fail("Unknown argument \""+sArgument+"\" to wounds");
+            }
+        }
+        if (!bToughnessGiven)
+            fail("wounds needs a toughness (T=...)");
+        auto pWounds = std::make_shared<WoundCalculatorObject>(pDamage, toughness.dValue, shaken.dValue!=0.);
+        if (!toughness.sParameter.empty())
+            vBinders.push_back([pWounds, toughness](const Bindings& bindings){
+                pWounds->setToughness(lookup(bindings, toughness.sParameter));
+            });
+        if (!shaken.sParameter.empty())
+            vBinders.push_back([pWounds, shaken](const Bindings& bindings){
+                pWounds->setShaken(lookup(bindings, shaken.sParameter)!=0.);
+            });
+        return Term{pWounds, .0, {}};
+    }
+    if (sName=="opposed" || sName=="margin") {
+        auto pAttacker = materialize(parseSum());
+        expect(',');
+        auto pDefender = materialize(parseSum());
+        auto pMargin = std::make_shared<OpposedRoll>(pAttacker, pDefender);
+        vBinders.push_back([pMargin](const Bindings&){pMargin->invalidate();});
+        if (sName=="margin")
+            return Term{pMargin, .0, {}};
+        return Term{OpposedRoll::countSuccesses(pMargin), .0, {}};
+    }
+    if (sName=="group") {
+        auto pMember = materialize(parseSum());
+        expect(',');
+        Scalar members = parseScalar();
+        if (members.sParameter.empty() && (members.dValue<.0 || members.dValue!=std::floor(members.dValue)))
+            fail("group needs a non-negative integer number of members");
+        auto pGroup = std::make_shared<GroupRoll>(pMember, (unsigned int)members.dValue);
+        // Runs after the binders of the member, so the group always sees the rebound member.
+        vBinders.push_back([pGroup, members](const Bindings& bindings){
+            if (!members.sParameter.empty()) {
+                double dMembers = lookup(bindings, members.sParameter);
+                if (dMembers<.0 || dMembers!=std::floor(dMembers))
+                    throw std::string{"$"}+members.sParameter+" must be a non-negative integer to be used as group size.";
+                pGroup->setMembers((unsigned int)dMembers);
+            }
+            pGroup->invalidate();
+        });
+        return Term{pGroup, .0, {}};
+    }
+    fail("Unknown function \""+sName+"\"");
+}
+
+std::shared_ptr<StochasticObject> DiceExpression::materialize(const Term& term) {
+    if (!term.pObject) {
+        auto pConstant = std::make_shared<ConstantObject>(term.dConstant);
+        if (!term.vParameters.empty())
+            vBinders.push_back([pConstant, term](const Bindings& bindings){
+                double dValue = term.dConstant;
+                for (auto &parameter: term.vParameters)
+                    dValue += parameter.first*lookup(bindings, parameter.second);
+                pConstant->setResult(dValue);
+            });
+        return pConstant;
+    }
+    if (term.dConstant==0. && term.vParameters.empty())
+        return term.pObject;
+    auto pModded = std::make_shared<FlatMod>(term.pObject, term.dConstant);
+    if (!term.vParameters.empty())
+        vBinders.push_back([pModded, term](const Bindings& bindings){
+            double dMod = term.dConstant;
+            for (auto &parameter: term.vParameters)
+                dMod += parameter.first*lookup(bindings, parameter.second);
+            pModded->setMod(dMod);
+        });
+    return pModded;
+}
+
+double DiceExpression::lookup(const Bindings& bindings, const std::string& sName) {
+    auto it = bindings.find(sName);
+    if (it==bindings.end())
+        throw std::string{"No value given for parameter $"}+sName+".";
+    return it->second;
+}
+
+std::shared_ptr<StochasticObject> DiceExpression::evaluate(const Bindings& bindings) {
+    for (auto &binder: vBinders)
+        binder(bindings);
+    return pRoot;
+}
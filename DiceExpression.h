@@ -0,0 +1,93 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __DICEEXPRESSION_H__
+#define __DICEEXPRESSION_H__
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "StochasticObject.h"
+
+// Compiles a dice expression into a graph of StochasticObjects once. Parameters ($name) are bound by
+// evaluate, which only updates the affected nodes, so the same plan serves many bindings.
+//
+//   expression := ['+'|'-'] term { ('+'|'-') term }
+//   term       := number | $name | d(sides|$name)! | '(' expression ')'
+//               | max(expression, expression, ...)
+//               | raises(expression)
+//               | wounds(expression, T=(number|$name) [, shaken[=(number|$name)]])
+//               | group(expression, (number|$name))
+//               | margin(expression, expression) | opposed(expression, expression)
+//
+// Only exploding dice (d8!) are supported, and dice can be added but not subtracted. margin is the
+// attacker's total minus the defender's, opposed counts the attacker's successes & raises against it.
+// Parentheses and calls nest at most nMaxDepth deep.
+// Example: wounds(max(d$trait!, d6!) + $mod + d8!, T=6, shaken)
+class DiceExpression {
+    public:
+        typedef std::map<std::string, double> Bindings;
+    private:
+        struct Term {
+            std::shared_ptr<StochasticObject> pObject;
+            double dConstant;
+            std::vector<std::pair<double, std::string>> vParameters;
+        };
+        struct Scalar {
+            double dValue;
+            std::string sParameter;
+        };
+
+        std::string sExpression;
+        std::size_t nPos;
+        std::size_t nDepth; // expressions currently open, bounded so the parser cannot exhaust the stack
+        static const std::size_t nMaxDepth = 256;
+        std::shared_ptr<StochasticObject> pRoot;
+        std::vector<std::function<void(const Bindings&)>> vBinders;
+        std::set<std::string> sParameters;
+
+        [[noreturn]] void fail(const std::string& sMessage) const;
+        void skipWhitespace(void);
+        bool consume(char c);
+        void expect(char c);
+        std::string parseIdentifier(void);
+        Scalar parseScalar(void);
+        Term parseSum(void);
+        Term parseTerm(void);
+        Term parseCall(const std::string& sName);
+        std::shared_ptr<StochasticObject> materialize(const Term& term);
+
+        static double lookup(const Bindings& bindings, const std::string& sName);
+    public:
+        // Throws a std::string describing the problem if sExpression_ cannot be parsed.
+        DiceExpression(const std::string& sExpression_);
+        ~DiceExpression(void) = default;
+
+        // Binds all parameters and returns the root of the plan. The returned object is the same for
+        // every call, so do not bind again while it is still being evaluated.
+        std::shared_ptr<StochasticObject> evaluate(const Bindings& bindings={});
+
+        const std::set<std::string>& getParameters(void) const {return sParameters;};
+        const std::string& getExpression(void) const {return sExpression;};
+};
+
+#endif
@@ -0,0 +1,133 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <string>
+
+#include "AcingDie.h"
+#include "AdderObject.h"
+#include "DiceSumKernel.h"
+#include "FlatMod.h"
+
+bool DiceSumKernel::collect(const StochasticObject& object, std::vector<unsigned int>& vSides, std::int64_t& nMod) {
+    // Iterative, so long chains of sums do not exhaust the stack.
+    std::vector<std::shared_ptr<StochasticObject>> vPending;
+    const StochasticObject* pObject = &object;
+    while (true) {
+        if (auto pDie = dynamic_cast<const AcingDie*>(pObject)) {
+            // A one sided die explodes forever.
+            if (pDie->getSides()<2)
+                return false;
+            vSides.push_back(pDie->getSides());
+        } else {
+            if (auto pMod = dynamic_cast<const FlatMod*>(pObject))
+                nMod += std::int64_t(pMod->getMod());
+            else if (!dynamic_cast<const AdderObject*>(pObject))
+                return false;
+            for (auto &pChild: pObject->getChildren())
+                vPending.push_back(pChild);
+        }
+        if (vPending.empty())
+            return true;
+        pObject = vPending.back().get();
+        // The node stays alive through its parent, which outlives this call.
+        vPending.pop_back();
+    }
+}
+
+bool DiceSumKernel::appliesTo(const StochasticObject& object) {
+    return countDice(object)>0;
+}
+
+std::size_t DiceSumKernel::countDice(const StochasticObject& object) {
+    if (auto pDie = dynamic_cast<const AcingDie*>(&object))
+        return pDie->getSides()<2 ? 0 : 1;
+    if (auto pAdder = dynamic_cast<const AdderObject*>(&object))
+        return pAdder->getDiceCount();
+    if (auto pMod = dynamic_cast<const FlatMod*>(&object))
+        return pMod->getDiceCount();
+    return 0;
+}
+
+std::size_t DiceSumKernel::countChildDice(const StochasticObject& object) {
+    std::size_t nDice = 0;
+    for (auto &pChild: object.getChildren()) {
+        auto nChildDice = pChild ? countDice(*pChild) : 0;
+        if (nChildDice==0)
+            return 0;
+        nDice += nChildDice;
+    }
+    return nDice;
+}
+
+std::shared_ptr<TabulatedObject> DiceSumKernel::tabulate(const StochasticObject& object, double dEpsilon, std::size_t nMaxSize) {
+    std::vector<unsigned int> vSides;
+    std::int64_t nMod = 0;
+    if (!collect(object, vSides, nMod) || vSides.empty())
+        return nullptr;
+    return tabulate(vSides, nMod, dEpsilon, nMaxSize);
+}
+
+std::shared_ptr<TabulatedObject> DiceSumKernel::tabulate(const std::vector<unsigned int>& vSides, std::int64_t nMod, double dEpsilon,
+        std::size_t nMaxSize) {
+    if (vSides.empty())
+        throw std::string{"DiceSumKernel needs at least one die."};
+    for (auto nSides: vSides)
+        if (nSides<2)
+            throw std::string{"A one sided AcingDie explodes forever."};
+    // Stage i is the sum of the first i dice, stage 0 is the constant 0. Each stage only looks nSides
+    // values back, so ring buffers of nRing values suffice.
+    std::size_t nStages = vSides.size()+1;
+    std::size_t nRing = *std::max_element(vSides.begin(), vSides.end())+1;
+    std::vector<double> vRing(nStages*nRing, .0);
+    std::vector<double> vWindow(nStages, .0);
+    auto at = [&](std::size_t nStage, std::size_t n) -> double& {return vRing[nStage*nRing+n%nRing];};
+
+    // Every die shows at least 1, so the sum starts at the number of dice.
+    std::size_t nFirst = vSides.size();
+    std::vector<double> vMass;
+    double dCDF = .0;
+    for (std::size_t n=0; vMass.size()<nMaxSize; ++n) {
+        at(0, n) = n==0 ? 1. : .0;
+        for (std::size_t nStage=1; nStage<nStages; ++nStage) {
+            std::size_t nSides = vSides[nStage-1];
+            // vWindow holds P[n-1] + ... + P[n-nSides+1] of the previous stage.
+            double &dWindow = vWindow[nStage];
+            if (n%nSides==0) {
+                // Recompute from scratch now and then, so cancellation errors do not accumulate.
+                dWindow = .0;
+                for (std::size_t k=1; k<nSides && k<=n; ++k)
+                    dWindow += at(nStage-1, n-k);
+            } else {
+                if (n>=1)
+                    dWindow += at(nStage-1, n-1);
+                if (n>=nSides)
+                    dWindow -= at(nStage-1, n-nSides);
+                // Cancellation may leave a tiny negative remainder until the next recomputation.
+                dWindow = std::max(dWindow, .0);
+            }
+            at(nStage, n) = ((n>=nSides ? at(nStage, n-nSides) : .0)+dWindow)/double(nSides);
+        }
+        if (n>=nFirst) {
+            vMass.push_back(at(nStages-1, n));
+            dCDF += vMass.back();
+            if (1.-dCDF<dEpsilon)
+                break;
+        }
+    }
+    return std::make_shared<TabulatedObject>(double(std::int64_t(nFirst)+nMod), vMass);
+}
@@ -0,0 +1,56 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __DICESUMKERNEL_H__
+#define __DICESUMKERNEL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "StochasticObject.h"
+#include "TabulatedObject.h"
+
+// Closed-form tabulation of sums of exploding dice plus flat modifiers, i.e. trees made of
+// AdderObject, FlatMod and AcingDie only.
+//
+// An acing die with s sides has the generating function z(1+z+...+z^(s-2))/(s-z^s), so adding one
+// such die to a distribution P gives Q with
+//     Q[n] = (Q[n-s] + P[n-1] + ... + P[n-s+1])/s,
+// a sliding window over P. The kernel runs this recurrence for all dice side by side, one output
+// value at a time, so the cost is linear in the output length per die. The window is updated by
+// adding the newest and subtracting the oldest term; to keep rounding from building up over long
+// outputs it is summed afresh every s values, which keeps the cost linear.
+class DiceSumKernel {
+    private:
+        // Collects the sides of all dice and the total modifier. False unless the tree has the
+        // supported form.
+        static bool collect(const StochasticObject& object, std::vector<unsigned int>& vSides, std::int64_t& nMod);
+    public:
+        static bool appliesTo(const StochasticObject& object);
+        // Table of the sum, or nullptr if the kernel does not apply to object.
+        static std::shared_ptr<TabulatedObject> tabulate(const StochasticObject& object, double dEpsilon=1e-9, std::size_t nMaxSize=1<<20);
+        static std::shared_ptr<TabulatedObject> tabulate(const std::vector<unsigned int>& vSides, std::int64_t nMod, double dEpsilon=1e-9,
+                                                         std::size_t nMaxSize=1<<20);
+        // Number of dice in object, 0 if the kernel does not apply. AdderObject and FlatMod compute their
+        // count once from their children (countChildDice), so this is constant time.
+        static std::size_t countDice(const StochasticObject& object);
+        static std::size_t countChildDice(const StochasticObject& object);
+};
+
+#endif
@@ -0,0 +1,271 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Hashing.h"
+#include "DistributionCache.h"
+
+namespace {
+    const char aMagic[4] = {'S','W','D','C'};
+    // Version 2 stores runs: nCount run starts, nCount run lengths, then the masses of all runs.
+    const std::uint32_t nFormatVersion = 2;
+    const char* sSuffix = ".swdist";
+
+    struct FileHeader {
+        char aMagic[4];
+        std::uint32_t nFormatVersion;
+        std::uint32_t nEngineVersion;
+        std::uint32_t nReserved;
+        double dMinimum;
+        std::uint64_t nKeyLength;
+        std::uint64_t nCount; // runs
+    };
+
+    std::size_t paddedKeyLength(std::uint64_t nKeyLength) {
+        return std::size_t((nKeyLength+7)/8*8);
+    }
+
+    bool makeDirectories(const std::string& sPath) {
+        for (std::size_t nPos=1; nPos<=sPath.size(); ++nPos) {
+            if (nPos<sPath.size() && sPath[nPos]!='/')
+                continue;
+            std::string sPrefix = sPath.substr(0, nPos);
+            if (mkdir(sPrefix.c_str(), 0755)!=0 && errno!=EEXIST)
+                return false;
+        }
+        struct stat info;
+        return stat(sPath.c_str(), &info)==0 && S_ISDIR(info.st_mode);
+    }
+}
+
+DistributionCache::DistributionCache(const std::string& sDirectory_, std::uint64_t nMaxBytes_):
+        sDirectory(sDirectory_), nMaxBytes(nMaxBytes_), bEnabled(false), bSizeKnown(false), nEstimatedBytes(0),
+        nHits(0), nMisses(0) {
+    if (!sDirectory.empty())
+        bEnabled = makeDirectories(sDirectory);
+}
+
+std::string DistributionCache::getDefaultDirectory(void) {
+    if (const char* sOverride = std::getenv("SWROLL_CACHE_DIR"))
+        return sOverride;
+    if (const char* sXdg = std::getenv("XDG_CACHE_HOME"))
+        if (*sXdg)
+            return std::string{sXdg}+"/SWRollCalculator";
+    if (const char* sHome = std::getenv("HOME"))
+        if (*sHome)
+            return std::string{sHome}+"/.cache/SWRollCalculator";
+    return "";
+}
+
+std::string DistributionCache::getKey(const StochasticObject& object, double dEpsilon) const {
+    std::ostringstream s;
+    s << "v"<<nEngineVersion<<";eps="<<std::setprecision(17)<<dEpsilon<<";"<<object.getDescription();
+    return s.str();
+}
+
+std::string DistributionCache::getPath(const std::string& sKey) const {
+    std::ostringstream s;
+    s << sDirectory<<"/"<<std::hex<<std::setw(16)<<std::setfill('0')<<hashString(sKey)<<sSuffix;
+    return s.str();
+}
+
+std::shared_ptr<TabulatedObject> DistributionCache::lookup(const StochasticObject& object, double dEpsilon) {
+    if (!bEnabled)
+        return nullptr;
+    auto sKey = getKey(object, dEpsilon);
+    auto sPath = getPath(sKey);
+    int nFd = open(sPath.c_str(), O_RDONLY);
+    if (nFd<0) {
+        ++nMisses;
+        return nullptr;
+    }
+    std::shared_ptr<TabulatedObject> pTable;
+    struct stat info;
+    if (fstat(nFd, &info)==0 && std::size_t(info.st_size)>=sizeof(FileHeader)) {
+        std::size_t nFileSize = std::size_t(info.st_size);
+        void* pMapped = mmap(nullptr, nFileSize, PROT_READ, MAP_PRIVATE, nFd, 0);
+        if (pMapped!=MAP_FAILED) {
+            auto pBytes = static_cast<const char*>(pMapped);
+            FileHeader header;
+            std::memcpy(&header, pBytes, sizeof(header));
+            std::size_t nDataOffset = sizeof(FileHeader)+paddedKeyLength(header.nKeyLength);
+            if (std::memcmp(header.aMagic, aMagic, sizeof(aMagic))==0 && header.nFormatVersion==nFormatVersion
+                    && header.nEngineVersion==nEngineVersion && header.nKeyLength==sKey.size()
+                    && header.nCount<=(nFileSize-std::min(nFileSize, nDataOffset))/16
+                    && std::memcmp(pBytes+sizeof(FileHeader), sKey.data(), sKey.size())==0) {
+                // Everything after the key is 8 byte aligned within the page aligned mapping, so it is read in place.
+                std::size_t nRuns = std::size_t(header.nCount);
+                auto pRunStart = reinterpret_cast<const std::int64_t*>(pBytes+nDataOffset);
+                auto pRunLength = reinterpret_cast<const std::uint64_t*>(pRunStart+nRuns);
+                std::size_t nMassOffset = nDataOffset+nRuns*16;
+                std::uint64_t nValues = 0;
+                bool bValid = true;
+                for (std::size_t i=0; i<nRuns && bValid; ++i) {
+                    bValid = pRunLength[i]<=nFileSize/sizeof(double);
+                    nValues += pRunLength[i];
+                }
+                if (bValid && nMassOffset+nValues*sizeof(double)==nFileSize)
+                    pTable = std::make_shared<TabulatedObject>(nRuns, pRunStart, pRunLength, reinterpret_cast<const double*>(pBytes+nMassOffset));
+            }
+            munmap(pMapped, nFileSize);
+        }
+    }
+    close(nFd);
+    if (pTable) {
+        ++nHits;
+        // Mark as recently used for the LRU eviction.
+        utimensat(AT_FDCWD, sPath.c_str(), nullptr, 0);
+    } else {
+        ++nMisses;
+    }
+    return pTable;
+}
+
+void DistributionCache::store(const StochasticObject& object, double dEpsilon, const TabulatedObject& table) {
+    if (!bEnabled)
+        return;
+    auto sKey = getKey(object, dEpsilon);
+    auto sPath = getPath(sKey);
+
+    FileHeader header;
+    std::memcpy(header.aMagic, aMagic, sizeof(aMagic));
+    header.nFormatVersion = nFormatVersion;
+    header.nEngineVersion = nEngineVersion;
+    header.nReserved = 0;
+    header.dMinimum = double(table.getIntMinimum());
+    header.nKeyLength = sKey.size();
+    auto vRuns = table.getRuns();
+    header.nCount = vRuns.size();
+    std::vector<std::int64_t> vRunStart;
+    std::vector<std::uint64_t> vRunLength;
+    std::size_t nValues = 0;
+    for (auto &run: vRuns) {
+        vRunStart.push_back(run.first);
+        vRunLength.push_back(run.second.size());
+        nValues += run.second.size();
+    }
+
+    // Write to a private temporary file and rename it, so readers never see partial entries.
+    std::ostringstream sTempPath;
+    sTempPath << sPath<<".tmp."<<getpid()<<"."<<std::hash<std::thread::id>()(std::this_thread::get_id());
+    {
+        std::ofstream file(sTempPath.str(), std::ios::binary|std::ios::trunc);
+        if (!file)
+            return;
+        std::vector<char> vPadding(paddedKeyLength(sKey.size())-sKey.size(), 0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(sKey.data(), std::streamsize(sKey.size()));
+        file.write(vPadding.data(), std::streamsize(vPadding.size()));
+        file.write(reinterpret_cast<const char*>(vRunStart.data()), std::streamsize(vRunStart.size()*sizeof(std::int64_t)));
+        file.write(reinterpret_cast<const char*>(vRunLength.data()), std::streamsize(vRunLength.size()*sizeof(std::uint64_t)));
+        for (auto &run: vRuns)
+            file.write(reinterpret_cast<const char*>(run.second.data()), std::streamsize(run.second.size()*sizeof(double)));
+        if (!file) {
+            file.close();
+            unlink(sTempPath.str().c_str());
+            return;
+        }
+    }
+    if (rename(sTempPath.str().c_str(), sPath.c_str())!=0) {
+        unlink(sTempPath.str().c_str());
+        return;
+    }
+    // Only rescan the directory once the running estimate crosses the limit.
+    {
+        std::unique_lock<std::mutex> lock(evictionMutex);
+        if (bSizeKnown) {
+            nEstimatedBytes += sizeof(header)+paddedKeyLength(sKey.size())+vRuns.size()*16+nValues*sizeof(double);
+            if (nEstimatedBytes<=nMaxBytes)
+                return;
+        }
+    }
+    evict();
+}
+
+std::shared_ptr<TabulatedObject> DistributionCache::getTabulated(const StochasticObject& object, double dEpsilon,
+        const std::function<std::shared_ptr<TabulatedObject>(void)>& compute) {
+    auto pTable = lookup(object, dEpsilon);
+    if (pTable)
+        return pTable;
+    pTable = compute?compute():object.tabulateDirectly(dEpsilon);
+    if (!pTable)
+        pTable = std::make_shared<TabulatedObject>(object, dEpsilon);
+    store(object, dEpsilon, *pTable);
+    return pTable;
+}
+
+void DistributionCache::evict(void) {
+    if (!bEnabled)
+        return;
+    std::unique_lock<std::mutex> lock(evictionMutex);
+    struct Entry {
+        std::string sPath;
+        std::uint64_t nSize;
+        struct timespec tAccess;
+    };
+    std::vector<Entry> vEntries;
+    std::uint64_t nTotal = 0;
+    DIR* pDir = opendir(sDirectory.c_str());
+    if (!pDir)
+        return;
+    std::size_t nSuffixLength = std::strlen(sSuffix);
+    while (struct dirent* pEntry = readdir(pDir)) {
+        std::string sName{pEntry->d_name};
+        if (sName.size()<=nSuffixLength || sName.compare(sName.size()-nSuffixLength, nSuffixLength, sSuffix)!=0)
+            continue;
+        Entry entry{sDirectory+"/"+sName, 0, {}};
+        struct stat info;
+        if (stat(entry.sPath.c_str(), &info)!=0)
+            continue;
+        entry.nSize = std::uint64_t(info.st_size);
+        entry.tAccess = info.st_mtim;
+        nTotal += entry.nSize;
+        vEntries.push_back(entry);
+    }
+    closedir(pDir);
+    bSizeKnown = true;
+    nEstimatedBytes = nTotal;
+    if (nTotal<=nMaxBytes)
+        return;
+    std::sort(vEntries.begin(), vEntries.end(), [](const Entry& a, const Entry& b){
+        if (a.tAccess.tv_sec!=b.tAccess.tv_sec)
+            return a.tAccess.tv_sec<b.tAccess.tv_sec;
+        return a.tAccess.tv_nsec<b.tAccess.tv_nsec;
+    });
+    for (auto &entry: vEntries) {
+        if (nTotal<=nMaxBytes)
+            break;
+        if (unlink(entry.sPath.c_str())==0)
+            nTotal -= entry.nSize;
+    }
+    nEstimatedBytes = nTotal;
+}
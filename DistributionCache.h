@@ -0,0 +1,76 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __DISTRIBUTIONCACHE_H__
+#define __DISTRIBUTIONCACHE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "StochasticObject.h"
+#include "TabulatedObject.h"
+
+// Persistent cache of tabulated distributions shared by all programs of SW Roll Calculator.
+// Entries are files named after a hash of the object description, the tabulation epsilon and the
+// engine version. They are memory-mapped when read. Once the directory grows beyond the size limit
+// the least recently used entries are deleted; the directory is only rescanned once a running estimate
+// of its size crosses the limit.
+class DistributionCache {
+    private:
+        std::string sDirectory;
+        std::uint64_t nMaxBytes;
+        bool bEnabled;
+        std::mutex evictionMutex;
+        // Size of the directory as of the last scan plus what was stored since, guarded by evictionMutex.
+        bool bSizeKnown;
+        std::uint64_t nEstimatedBytes;
+        std::atomic<std::uint64_t> nHits;
+        std::atomic<std::uint64_t> nMisses;
+
+        std::string getKey(const StochasticObject& object, double dEpsilon) const;
+        std::string getPath(const std::string& sKey) const;
+    public:
+        // Increase whenever a change to any StochasticObject changes the distributions it produces.
+        static const std::uint32_t nEngineVersion = 2;
+
+        DistributionCache(const std::string& sDirectory_=getDefaultDirectory(), std::uint64_t nMaxBytes_=64ull<<20);
+        ~DistributionCache(void) = default;
+
+        // Returns nullptr on a miss.
+        std::shared_ptr<TabulatedObject> lookup(const StochasticObject& object, double dEpsilon);
+        void store(const StochasticObject& object, double dEpsilon, const TabulatedObject& table);
+        // Looks the object up and tabulates and stores it on a miss, using compute if given.
+        std::shared_ptr<TabulatedObject> getTabulated(const StochasticObject& object, double dEpsilon=1e-9,
+                const std::function<std::shared_ptr<TabulatedObject>(void)>& compute=nullptr);
+        // Deletes least recently used entries until the cache fits into its size limit.
+        void evict(void);
+
+        bool isEnabled(void) const {return bEnabled;};
+        const std::string& getDirectory(void) const {return sDirectory;};
+        std::uint64_t getHits(void) const {return nHits;};
+        std::uint64_t getMisses(void) const {return nMisses;};
+
+        // $SWROLL_CACHE_DIR, otherwise SWRollCalculator in $XDG_CACHE_HOME or ~/.cache.
+        // An empty $SWROLL_CACHE_DIR disables the cache.
+        static std::string getDefaultDirectory(void);
+};
+
+#endif
@@ -15,16 +15,67 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
+#include "DiceSumKernel.h"
 #include "FlatMod.h"
+#include "ImportanceSampler.h"
 
-FlatMod::FlatMod(const std::shared_ptr<StochasticObject>& pObject_, double dMod_): pObject(pObject_), dMod(dMod_) {
+FlatMod::FlatMod(const std::shared_ptr<StochasticObject>& pObject_, double dMod_): pObject(pObject_), nMod(toInteger(dMod_, "FlatMod modifier")), nDice(0) {
+    nDice = DiceSumKernel::countChildDice(*this);
 }
 
-double FlatMod::distributionFunction(double dX) const {
-    return pObject->distributionFunction(dX-dMod);
+double FlatMod::cdfAt(std::int64_t n) const {
+    return pObject->cdfAt(addSaturated(n, -nMod));
 }
 
-double FlatMod::getMinimum(void) const {
-    return pObject->getMinimum()+dMod;
+double FlatMod::pmfAt(std::int64_t n) const {
+    return pObject->pmfAt(addSaturated(n, -nMod));
 }
 
+std::int64_t FlatMod::getIntMinimum(void) const {
+    return addSaturated(pObject->getIntMinimum(), nMod);
+}
+
+double FlatMod::mean(void) const {
+    return pObject->mean()+double(nMod);
+}
+
+double FlatMod::variance(void) const {
+    return pObject->variance();
+}
+
+std::int64_t FlatMod::sample(ImportanceSampler& sampler) const {
+    return addSaturated(pObject->sample(sampler), nMod);
+}
+
+std::int64_t FlatMod::getIntMaximum(void) const {
+    if (pObject->getIntMaximum()==nUnbounded)
+        return nUnbounded;
+    return addSaturated(pObject->getIntMaximum(), nMod);
+}
+
+std::string FlatMod::getDescription(void) const {
+    return "FlatMod("+pObject->getDescription()+","+std::to_string(nMod)+")";
+}
+
+std::vector<std::shared_ptr<StochasticObject>> FlatMod::getChildren(void) const {
+    return {pObject};
+}
+
+std::shared_ptr<StochasticObject> FlatMod::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<FlatMod>(vChildren.at(0), double(nMod));
+}
+
+bool FlatMod::canTabulateDirectly(void) const {
+    return nDice>0;
+}
+
+std::shared_ptr<TabulatedObject> FlatMod::tabulateDirectly(double dEpsilon, std::size_t nMaxSize) const {
+    return DiceSumKernel::tabulate(*this, dEpsilon, nMaxSize);
+}
+
+StochasticObject::CostEstimate FlatMod::estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const {
+    auto estimate = StochasticObject::estimateCost(vChildren, dEpsilon);
+    if (nDice>0)
+        estimate.dCombineCost = 4.*double(nDice)*estimate.dSupport;
+    return estimate;
+}
@@ -24,13 +24,30 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 class FlatMod: public StochasticObject {
     private:
         std::shared_ptr<StochasticObject> pObject;
-        double dMod;
+        std::int64_t nMod;
+        std::size_t nDice;
     public:
         FlatMod(const std::shared_ptr<StochasticObject>& pObject_, double dMod);
         virtual ~FlatMod(void) = default;
 
-        virtual double distributionFunction(double) const;
-        virtual double getMinimum(void) const;
+        virtual double cdfAt(std::int64_t n) const;
+        virtual double pmfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+        virtual bool canTabulateDirectly(void) const;
+        // Dice below this node if it only sums acing dice and modifiers, otherwise 0 (see DiceSumKernel).
+        std::size_t getDiceCount(void) const {return nDice;};
+        virtual CostEstimate estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const;
+        virtual std::shared_ptr<TabulatedObject> tabulateDirectly(double dEpsilon, std::size_t nMaxSize=1<<20) const;
+
+        double getMod(void) const {return double(nMod);};
+        void setMod(double dMod_) {nMod=toInteger(dMod_, "FlatMod modifier");};
 };
 
 
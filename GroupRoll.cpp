@@ -0,0 +1,194 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+#include "GroupRoll.h"
+
+GroupRoll::GroupRoll(const std::shared_ptr<StochasticObject>& pMember_, unsigned int nMembers_, double dEpsilon_):
+        pMember(pMember_), nMembers(nMembers_), dEpsilon(dEpsilon_) {
+}
+
+void GroupRoll::setMembers(unsigned int nMembers_) {
+    std::unique_lock<std::mutex> lock(distributionMutex);
+    nMembers = nMembers_;
+    pDistribution.reset();
+}
+
+void GroupRoll::invalidate(void) {
+    std::unique_lock<std::mutex> lock(distributionMutex);
+    pMemberMass.reset();
+    pDistribution.reset();
+}
+
+// Mass of max(member, 0), cut off once less than dEpsilon probability is left.
+const std::vector<double>& GroupRoll::getMemberMass(void) const {
+    if (!pMemberMass) {
+        auto pMass = std::make_shared<std::vector<double>>();
+        auto nMaximum = pMember->getIntMaximum();
+        double dCDF = pMember->cdfAt(0);
+        pMass->push_back(dCDF);
+        for (std::int64_t n=1; n<=nMaximum && 1.-dCDF>=dEpsilon && pMass->size()<(1<<20); ++n) {
+            double dMass = pMember->pmfAt(n);
+            pMass->push_back(dMass);
+            dCDF += dMass;
+        }
+        pMemberMass = pMass;
+    }
+    return *pMemberMass;
+}
+
+std::vector<double> GroupRoll::convolve(const std::vector<double>& vLeft, const std::vector<double>& vRight) const {
+    std::vector<double> vResult(vLeft.size()+vRight.size()-1, .0);
+    for (std::size_t i=0; i<vLeft.size(); ++i) {
+        if (vLeft[i]==.0)
+            continue;
+        for (std::size_t j=0; j<vRight.size(); ++j)
+            vResult[i+j] += vLeft[i]*vRight[j];
+    }
+    // Drop the tail that carries less than dEpsilon probability, so repeated squaring stays small.
+    double dTail = .0;
+    while (vResult.size()>1 && dTail+vResult.back()<dEpsilon) {
+        dTail += vResult.back();
+        vResult.pop_back();
+    }
+    return vResult;
+}
+
+std::vector<double> GroupRoll::binomial(double dP) const {
+    std::vector<double> vMass(std::size_t(nMembers)+1, .0);
+    if (dP<=.0) {
+        vMass[0] = 1.;
+        return vMass;
+    }
+    if (dP>=1.) {
+        vMass[nMembers] = 1.;
+        return vMass;
+    }
+    double dN = double(nMembers);
+    for (unsigned int k=0; k<=nMembers; ++k) {
+        double dK = double(k);
+        double dLogMass = std::lgamma(dN+1.)-std::lgamma(dK+1.)-std::lgamma(dN-dK+1.)
+                          + dK*std::log(dP) + (dN-dK)*std::log1p(-dP);
+        vMass[k] = std::exp(dLogMass);
+    }
+    return vMass;
+}
+
+std::shared_ptr<const std::vector<double>> GroupRoll::getDistribution(void) const {
+    std::unique_lock<std::mutex> lock(distributionMutex);
+    if (pDistribution)
+        return pDistribution;
+    auto &vMember = getMemberMass();
+    std::vector<double> vMass;
+    if (vMember.size()<=2) {
+        vMass = binomial(vMember.size()<2 ? .0 : vMember[1]);
+    } else {
+        vMass = {1.};
+        std::vector<double> vPower = vMember;
+        for (unsigned int nRemaining=nMembers; nRemaining>0; nRemaining>>=1) {
+            if (nRemaining&1u)
+                vMass = convolve(vMass, vPower);
+            if (nRemaining>1)
+                vPower = convolve(vPower, vPower);
+        }
+    }
+    auto pCDF = std::make_shared<std::vector<double>>(vMass.size(), .0);
+    double dCDF = .0;
+    for (std::size_t i=0; i<vMass.size(); ++i) {
+        dCDF += vMass[i];
+        (*pCDF)[i] = dCDF;
+    }
+    pDistribution = pCDF;
+    return pDistribution;
+}
+
+double GroupRoll::cdfAt(std::int64_t n) const {
+    if (n<0)
+        return .0;
+    auto pCDF = getDistribution();
+    auto &vDistribution = *pCDF;
+    if (std::uint64_t(n)>=vDistribution.size())
+        return 1.;
+    return vDistribution[std::size_t(n)];
+}
+
+double GroupRoll::pmfAt(std::int64_t n) const {
+    if (n<0)
+        return .0;
+    auto pCDF = getDistribution();
+    auto &vDistribution = *pCDF;
+    if (std::uint64_t(n)>=vDistribution.size())
+        return std::uint64_t(n)==vDistribution.size() ? 1.-vDistribution.back() : .0;
+    return n==0 ? vDistribution[0] : vDistribution[std::size_t(n)]-vDistribution[std::size_t(n)-1];
+}
+
+std::int64_t GroupRoll::getIntMinimum(void) const {
+    return 0;
+}
+
+std::int64_t GroupRoll::getIntMaximum(void) const {
+    auto nMaximum = std::max<std::int64_t>(pMember->getIntMaximum(), 0);
+    if (nMaximum==nUnbounded)
+        return nUnbounded;
+    if (nMaximum>0 && nMembers>nUnbounded/nMaximum)
+        return nUnbounded;
+    return nMaximum*std::int64_t(nMembers);
+}
+
+// Members are independent, so the moments of one member scale with the group size.
+double GroupRoll::mean(void) const {
+    std::unique_lock<std::mutex> lock(distributionMutex);
+    auto &vMember = getMemberMass();
+    double dMean = .0;
+    for (std::size_t k=1; k<vMember.size(); ++k)
+        dMean += vMember[k]*double(k);
+    return double(nMembers)*dMean;
+}
+
+double GroupRoll::variance(void) const {
+    std::unique_lock<std::mutex> lock(distributionMutex);
+    auto &vMember = getMemberMass();
+    double dMean = .0, dSecond = .0;
+    for (std::size_t k=1; k<vMember.size(); ++k) {
+        dMean += vMember[k]*double(k);
+        dSecond += vMember[k]*double(k)*double(k);
+    }
+    return double(nMembers)*std::max(.0, dSecond-dMean*dMean);
+}
+
+std::string GroupRoll::getDescription(void) const {
+    return "GroupRoll("+pMember->getDescription()+","+std::to_string(nMembers)+")";
+}
+
+std::vector<std::shared_ptr<StochasticObject>> GroupRoll::getChildren(void) const {
+    return {pMember};
+}
+
+std::shared_ptr<StochasticObject> GroupRoll::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<GroupRoll>(vChildren.at(0), nMembers, dEpsilon);
+}
+
+// The first query tabulates the member and convolves it O(log nMembers) times; later queries are lookups.
+StochasticObject::CostEstimate GroupRoll::estimateCost(const std::vector<CostEstimate>& vChildren, double) const {
+    auto &member = vChildren.at(0);
+    double dSupport = member.dSupport*double(std::max(nMembers, 1u));
+    double dConvolutions = dSupport*dSupport*(1.+std::log2(double(std::max(nMembers, 1u))));
+    return {dSupport, 1., member.dSetupCost+member.dSupport*member.dQueryCost+dConvolutions, member.dSupport+dConvolutions};
+}
@@ -0,0 +1,68 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __GROUPROLL_H__
+#define __GROUPROLL_H__
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "StochasticObject.h"
+
+// Total successes & raises of nMembers identical, independent rolls, e.g. a group of Extras. Member
+// outcomes below zero (failures and critical failures) count as zero. The distribution is computed
+// on first use, binomially if members score at most one, otherwise by convolving the member
+// distribution with itself through repeated squaring, so only O(log nMembers) convolutions are needed.
+class GroupRoll: public StochasticObject {
+    private:
+        std::shared_ptr<StochasticObject> pMember;
+        unsigned int nMembers;
+        double dEpsilon;
+
+        mutable std::mutex distributionMutex;
+        mutable std::shared_ptr<const std::vector<double>> pMemberMass;
+        mutable std::shared_ptr<const std::vector<double>> pDistribution;
+
+        const std::vector<double>& getMemberMass(void) const;
+        // Returned by value, so the table stays valid for the caller even if invalidate runs meanwhile.
+        std::shared_ptr<const std::vector<double>> getDistribution(void) const;
+        std::vector<double> convolve(const std::vector<double>& vLeft, const std::vector<double>& vRight) const;
+        std::vector<double> binomial(double dP) const;
+    public:
+        GroupRoll(const std::shared_ptr<StochasticObject>& pMember_, unsigned int nMembers_, double dEpsilon_=1e-12);
+        virtual ~GroupRoll(void) = default;
+
+        virtual double cdfAt(std::int64_t n) const;
+        virtual double pmfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+        virtual CostEstimate estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const;
+
+        unsigned int getMembers(void) const {return nMembers;};
+        void setMembers(unsigned int nMembers_);
+        // Drops the cached distribution, call it after modifying the member object.
+        void invalidate(void);
+};
+
+#endif
@@ -0,0 +1,39 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __HASHING_H__
+#define __HASHING_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64 bit FNV-1a hash. Pass the result of a previous call as nHash to hash several pieces in sequence.
+inline std::uint64_t hashBytes(const void* pData, std::size_t nSize, std::uint64_t nHash=14695981039346656037ull) {
+    auto pBytes = static_cast<const unsigned char*>(pData);
+    for (std::size_t i=0; i<nSize; ++i) {
+        nHash ^= pBytes[i];
+        nHash *= 1099511628211ull;
+    }
+    return nHash;
+}
+
+inline std::uint64_t hashString(const std::string& sText, std::uint64_t nHash=14695981039346656037ull) {
+    return hashBytes(sText.data(), sText.size(), nHash);
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+#include "StochasticObject.h"
+#include "ImportanceSampler.h"
+
+ImportanceSampler::ImportanceSampler(double dExplodeProbability_, std::uint64_t nSeed):
+        dExplodeProbability(dExplodeProbability_), dWeight(1.), generator(nSeed) {
+    if (!(dExplodeProbability>=.0 && dExplodeProbability<1.))
+        throw std::string{"The explosion probability must be at least 0 and less than 1."};
+}
+
+double ImportanceSampler::uniform(void) {
+    return std::uniform_real_distribution<double>(.0, 1.)(generator);
+}
+
+std::int64_t ImportanceSampler::uniformInteger(std::int64_t nFrom, std::int64_t nTo) {
+    return std::uniform_int_distribution<std::int64_t>(nFrom, nTo)(generator);
+}
+
+bool ImportanceSampler::explode(double dProbability) {
+    // Only ever push towards more explosions, that is where the rare outcomes are.
+    double dBiased = std::max(dProbability, dExplodeProbability);
+    bool bExplode = uniform()<dBiased;
+    if (dBiased!=dProbability)
+        dWeight *= bExplode ? dProbability/dBiased : (1.-dProbability)/(1.-dBiased);
+    return bExplode;
+}
+
+ImportanceSampler::Estimate ImportanceSampler::estimate(const StochasticObject& object, std::int64_t nAtLeast, std::size_t nSamples) {
+    if (nSamples<2)
+        throw std::string{"An estimate needs at least 2 samples."};
+    double dSum = .0, dSumOfSquares = .0;
+    std::size_t nHits = 0;
+    for (std::size_t i=0; i<nSamples; ++i) {
+        dWeight = 1.;
+        if (object.sample(*this)>=nAtLeast) {
+            dSum += dWeight;
+            dSumOfSquares += dWeight*dWeight;
+            ++nHits;
+        }
+    }
+    double dN = double(nSamples);
+    Estimate result;
+    result.dProbability = dSum/dN;
+    double dVariance = std::max(.0, (dSumOfSquares-dN*result.dProbability*result.dProbability)/(dN-1.));
+    result.dStandardError = std::sqrt(dVariance/dN);
+    result.dLower = std::max(.0, result.dProbability-1.96*result.dStandardError);
+    result.dUpper = std::min(1., result.dProbability+1.96*result.dStandardError);
+    result.nSamples = nSamples;
+    result.nHits = nHits;
+    return result;
+}
@@ -0,0 +1,66 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __IMPORTANCESAMPLER_H__
+#define __IMPORTANCESAMPLER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+
+class StochasticObject;
+
+// Monte Carlo estimates of tail probabilities with importance sampling. While drawing a sample, every
+// exploding die explodes with at least dExplodeProbability instead of 1/sides, and the sample is
+// weighted by the likelihood ratio of the natural and the biased rolls. Rare events with many
+// explosions are then hit often while the weighted estimate stays unbiased. dExplodeProbability = 0
+// gives plain Monte Carlo.
+//
+// A sampler is not thread-safe, use one per thread.
+class ImportanceSampler {
+    public:
+        struct Estimate {
+            double dProbability;
+            double dStandardError;
+            // 95% confidence interval from the normal approximation.
+            double dLower;
+            double dUpper;
+            std::size_t nSamples;
+            std::size_t nHits;
+        };
+    private:
+        double dExplodeProbability;
+        double dWeight;
+        std::mt19937_64 generator;
+    public:
+        ImportanceSampler(double dExplodeProbability_=.0, std::uint64_t nSeed=5489u);
+        ~ImportanceSampler(void) = default;
+
+        // Estimates P(object >= nAtLeast) from nSamples weighted samples.
+        Estimate estimate(const StochasticObject& object, std::int64_t nAtLeast, std::size_t nSamples);
+
+        // For StochasticObject::sample implementations.
+        double uniform(void);
+        std::int64_t uniformInteger(std::int64_t nFrom, std::int64_t nTo);
+        // Decides whether a die with natural explosion probability dProbability explodes.
+        bool explode(double dProbability);
+
+        double getWeight(void) const {return dWeight;};
+        double getExplodeProbability(void) const {return dExplodeProbability;};
+};
+
+#endif
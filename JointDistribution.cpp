@@ -0,0 +1,129 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <algorithm>
+#include <limits>
+
+#include "JointDistribution.h"
+
+JointDistribution::JointDistribution(std::int64_t nRowMinimum_, std::size_t nRows_, std::int64_t nColumnMinimum_, std::size_t nColumns_):
+        nRowMinimum(nRowMinimum_), nRows(nRows_), nColumnMinimum(nColumnMinimum_), nColumns(nColumns_) {
+    if (nRows==0 || nColumns==0 || nRows>(std::size_t(1)<<28)/nColumns)
+        throw std::string{"JointDistribution needs between 1 and 2^28 entries."};
+    vMass.assign(nRows*nColumns, .0);
+}
+
+bool JointDistribution::contains(std::int64_t nRow, std::int64_t nColumn) const {
+    return nRow>=nRowMinimum && std::uint64_t(nRow-nRowMinimum)<nRows
+        && nColumn>=nColumnMinimum && std::uint64_t(nColumn-nColumnMinimum)<nColumns;
+}
+
+std::size_t JointDistribution::getIndex(std::int64_t nRow, std::int64_t nColumn) const {
+    return std::size_t(nRow-nRowMinimum)*nColumns + std::size_t(nColumn-nColumnMinimum);
+}
+
+double JointDistribution::getMass(std::int64_t nRow, std::int64_t nColumn) const {
+    if (!contains(nRow, nColumn))
+        return .0;
+    return vMass[getIndex(nRow, nColumn)];
+}
+
+void JointDistribution::addMass(std::int64_t nRow, std::int64_t nColumn, double dMass) {
+    if (!contains(nRow, nColumn))
+        throw std::string{"JointDistribution entry ("}+std::to_string(nRow)+","+std::to_string(nColumn)+") is out of range.";
+    vMass[getIndex(nRow, nColumn)] += dMass;
+}
+
+std::shared_ptr<TabulatedObject> JointDistribution::getRowMarginal(void) const {
+    std::vector<double> vRowMass(nRows, .0);
+    for (std::size_t r=0; r<nRows; ++r)
+        for (std::size_t c=0; c<nColumns; ++c)
+            vRowMass[r] += vMass[r*nColumns+c];
+    return std::make_shared<TabulatedObject>(double(nRowMinimum), vRowMass);
+}
+
+std::shared_ptr<TabulatedObject> JointDistribution::getColumnMarginal(void) const {
+    std::vector<double> vColumnMass(nColumns, .0);
+    for (std::size_t r=0; r<nRows; ++r)
+        for (std::size_t c=0; c<nColumns; ++c)
+            vColumnMass[c] += vMass[r*nColumns+c];
+    return std::make_shared<TabulatedObject>(double(nColumnMinimum), vColumnMass);
+}
+
+std::shared_ptr<TabulatedObject> JointDistribution::getColumnGivenRow(std::int64_t nRow) const {
+    if (nRow<nRowMinimum || std::uint64_t(nRow-nRowMinimum)>=nRows)
+        throw std::string{"Row "}+std::to_string(nRow)+" has probability 0.";
+    auto itRow = vMass.begin()+std::ptrdiff_t(std::size_t(nRow-nRowMinimum)*nColumns);
+    std::vector<double> vConditional(itRow, itRow+std::ptrdiff_t(nColumns));
+    double dTotal = .0;
+    for (auto dMass: vConditional)
+        dTotal += dMass;
+    if (!(dTotal>.0))
+        throw std::string{"Row "}+std::to_string(nRow)+" has probability 0.";
+    for (auto &dMass: vConditional)
+        dMass /= dTotal;
+    return std::make_shared<TabulatedObject>(double(nColumnMinimum), vConditional);
+}
+
+std::shared_ptr<TabulatedObject> JointDistribution::getRowGivenColumn(std::int64_t nColumn) const {
+    if (nColumn<nColumnMinimum || std::uint64_t(nColumn-nColumnMinimum)>=nColumns)
+        throw std::string{"Column "}+std::to_string(nColumn)+" has probability 0.";
+    std::size_t c = std::size_t(nColumn-nColumnMinimum);
+    std::vector<double> vConditional(nRows, .0);
+    double dTotal = .0;
+    for (std::size_t r=0; r<nRows; ++r) {
+        vConditional[r] = vMass[r*nColumns+c];
+        dTotal += vConditional[r];
+    }
+    if (!(dTotal>.0))
+        throw std::string{"Column "}+std::to_string(nColumn)+" has probability 0.";
+    for (auto &dMass: vConditional)
+        dMass /= dTotal;
+    return std::make_shared<TabulatedObject>(double(nRowMinimum), vConditional);
+}
+
+double JointDistribution::getProbability(std::int64_t nRowFrom, std::int64_t nRowTo, std::int64_t nColumnFrom, std::int64_t nColumnTo) const {
+    // Clip the rectangle to the table first, the bounds may be far outside of it.
+    auto nRowMaximum = nRowMinimum+std::int64_t(nRows)-1;
+    auto nColumnMaximum = nColumnMinimum+std::int64_t(nColumns)-1;
+    nRowFrom = std::max(nRowFrom, nRowMinimum);
+    nRowTo = std::min(nRowTo, nRowMaximum);
+    nColumnFrom = std::max(nColumnFrom, nColumnMinimum);
+    nColumnTo = std::min(nColumnTo, nColumnMaximum);
+    double dProbability = .0;
+    for (auto nRow=nRowFrom; nRow<=nRowTo; ++nRow)
+        for (auto nColumn=nColumnFrom; nColumn<=nColumnTo; ++nColumn)
+            dProbability += vMass[getIndex(nRow, nColumn)];
+    return dProbability;
+}
+
+std::shared_ptr<JointDistribution> JointDistribution::mapColumns(const std::function<std::int64_t(std::int64_t)>& map) const {
+    std::vector<std::int64_t> vMapped(nColumns);
+    std::int64_t nMinimum = std::numeric_limits<std::int64_t>::max();
+    std::int64_t nMaximum = std::numeric_limits<std::int64_t>::min();
+    for (std::size_t c=0; c<nColumns; ++c) {
+        vMapped[c] = map(nColumnMinimum+std::int64_t(c));
+        nMinimum = std::min(nMinimum, vMapped[c]);
+        nMaximum = std::max(nMaximum, vMapped[c]);
+    }
+    auto pMapped = std::make_shared<JointDistribution>(nRowMinimum, nRows, nMinimum, std::size_t(nMaximum-nMinimum)+1);
+    for (std::size_t r=0; r<nRows; ++r)
+        for (std::size_t c=0; c<nColumns; ++c)
+            pMapped->vMass[r*pMapped->nColumns+std::size_t(vMapped[c]-nMinimum)] += vMass[r*nColumns+c];
+    return pMapped;
+}
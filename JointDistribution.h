@@ -0,0 +1,68 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __JOINTDISTRIBUTION_H__
+#define __JOINTDISTRIBUTION_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "TabulatedObject.h"
+
+// Joint probability mass of two integer valued quantities, e.g. (hit/raise level, damage), stored
+// densely in row-major order. Marginals, conditionals and rectangle probabilities are computed from
+// the table alone, so further questions about the same attack need no new object graph.
+class JointDistribution {
+    private:
+        std::int64_t nRowMinimum;
+        std::size_t nRows;
+        std::int64_t nColumnMinimum;
+        std::size_t nColumns;
+        std::vector<double> vMass;
+
+        std::size_t getIndex(std::int64_t nRow, std::int64_t nColumn) const;
+        bool contains(std::int64_t nRow, std::int64_t nColumn) const;
+    public:
+        // All mass starts out as zero.
+        JointDistribution(std::int64_t nRowMinimum_, std::size_t nRows_, std::int64_t nColumnMinimum_, std::size_t nColumns_);
+        ~JointDistribution(void) = default;
+
+        double getMass(std::int64_t nRow, std::int64_t nColumn) const;
+        void addMass(std::int64_t nRow, std::int64_t nColumn, double dMass);
+
+        // P(row) and P(column).
+        std::shared_ptr<TabulatedObject> getRowMarginal(void) const;
+        std::shared_ptr<TabulatedObject> getColumnMarginal(void) const;
+        // P(column | row) and P(row | column). Throws if the condition has probability 0.
+        std::shared_ptr<TabulatedObject> getColumnGivenRow(std::int64_t nRow) const;
+        std::shared_ptr<TabulatedObject> getRowGivenColumn(std::int64_t nColumn) const;
+        // P(nRowFrom <= row <= nRowTo and nColumnFrom <= column <= nColumnTo).
+        double getProbability(std::int64_t nRowFrom, std::int64_t nRowTo, std::int64_t nColumnFrom, std::int64_t nColumnTo) const;
+        // Joint distribution of (row, map(column)), e.g. to turn damage into wounds.
+        std::shared_ptr<JointDistribution> mapColumns(const std::function<std::int64_t(std::int64_t)>& map) const;
+
+        std::int64_t getRowMinimum(void) const {return nRowMinimum;};
+        std::size_t getRows(void) const {return nRows;};
+        std::int64_t getColumnMinimum(void) const {return nColumnMinimum;};
+        std::size_t getColumns(void) const {return nColumns;};
+        const std::vector<double>& getData(void) const {return vMass;};
+};
+
+#endif
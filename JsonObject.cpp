@@ -0,0 +1,269 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include "JsonObject.h"
+
+namespace {
+    class JsonParser {
+        private:
+            const std::string& sText;
+            std::size_t nPos;
+        public:
+            JsonParser(const std::string& sText_): sText(sText_), nPos(0) {};
+
+            void skipWhitespace(void) {
+                while (nPos<sText.size() && std::isspace((unsigned char)sText[nPos]))
+                    ++nPos;
+            }
+            bool atEnd(void) {
+                skipWhitespace();
+                return nPos>=sText.size();
+            }
+            char peek(void) {
+                skipWhitespace();
+                if (nPos>=sText.size())
+                    throw std::string{"Unexpected end of JSON input."};
+                return sText[nPos];
+            }
+            void expect(char c) {
+                if (peek()!=c)
+                    throw std::string{"Expected '"}+c+"' at position "+std::to_string(nPos)+".";
+                ++nPos;
+            }
+            bool consume(char c) {
+                if (peek()!=c)
+                    return false;
+                ++nPos;
+                return true;
+            }
+            std::string parseString(void) {
+                expect('"');
+                std::string sResult;
+                while (nPos<sText.size() && sText[nPos]!='"') {
+                    char c = sText[nPos++];
+                    if (c=='\\') {
+                        if (nPos>=sText.size())
+                            break;
+                        char e = sText[nPos++];
+                        switch (e) {
+                            case 'n': sResult += '\n'; break;
+                            case 't': sResult += '\t'; break;
+                            case 'r': sResult += '\r'; break;
+                            case 'b': sResult += '\b'; break;
+                            case 'f': sResult += '\f'; break;
+                            case 'u': throw std::string{"Unicode escapes are not supported."};
+                            default: sResult += e;
+                        }
+                    } else {
+                        sResult += c;
+                    }
+                }
+                if (nPos>=sText.size())
+                    throw std::string{"Unterminated JSON string."};
+                ++nPos;
+                return sResult;
+            }
+            // JSON number syntax only, so strtod never sees nan, inf or hexadecimal numbers.
+            double parseNumber(void) {
+                std::size_t nStart = nPos;
+                auto digits = [this](){
+                    std::size_t nFirst = nPos;
+                    while (nPos<sText.size() && std::isdigit((unsigned char)sText[nPos]))
+                        ++nPos;
+                    return nPos>nFirst;
+                };
+                if (nPos<sText.size() && sText[nPos]=='-')
+                    ++nPos;
+                bool bValid = digits();
+                if (bValid && nPos<sText.size() && sText[nPos]=='.') {
+                    ++nPos;
+                    bValid = digits();
+                }
+                if (bValid && nPos<sText.size() && (sText[nPos]=='e' || sText[nPos]=='E')) {
+                    ++nPos;
+                    if (nPos<sText.size() && (sText[nPos]=='+' || sText[nPos]=='-'))
+                        ++nPos;
+                    bValid = digits();
+                }
+                if (!bValid)
+                    throw std::string{"Unexpected character in JSON at position "}+std::to_string(nPos)+".";
+                double dNumber = std::strtod(sText.substr(nStart, nPos-nStart).c_str(), nullptr);
+                if (!std::isfinite(dNumber))
+                    throw std::string{"JSON number out of range at position "}+std::to_string(nStart)+".";
+                return dNumber;
+            }
+            // Arrays hold plain values only, so the parser never recurses more than one level.
+            JsonValue parseValue(bool bInArray=false) {
+                JsonValue value;
+                char c = peek();
+                if (c=='"') {
+                    value.type = JsonValue::Type::String;
+                    value.sString = parseString();
+                } else if (c=='[') {
+                    if (bInArray)
+                        throw std::string{"Nested JSON arrays are not supported at position "}+std::to_string(nPos)+".";
+                    ++nPos;
+                    value.type = JsonValue::Type::Array;
+                    if (!consume(']')) {
+                        do {
+                            value.vArray.push_back(parseValue(true));
+                        } while (consume(','));
+                        expect(']');
+                    }
+                } else if (sText.compare(nPos, 4, "true")==0) {
+                    nPos += 4;
+                    value.type = JsonValue::Type::Boolean;
+                    value.bBoolean = true;
+                } else if (sText.compare(nPos, 5, "false")==0) {
+                    nPos += 5;
+                    value.type = JsonValue::Type::Boolean;
+                    value.bBoolean = false;
+                } else if (sText.compare(nPos, 4, "null")==0) {
+                    nPos += 4;
+                } else {
+                    value.type = JsonValue::Type::Number;
+                    value.dNumber = parseNumber();
+                }
+                return value;
+            }
+    };
+}
+
+std::string JsonValue::toString(void) const {
+    std::ostringstream s;
+    switch (type) {
+        case Type::Null: s << "null"; break;
+        case Type::Number:
+            // Integers such as request ids are written exactly, other numbers so they read back unchanged.
+            if (dNumber==std::floor(dNumber) && std::fabs(dNumber)<9007199254740992.) {
+                s << (long long)dNumber;
+            } else {
+                // 15 digits where they suffice (0.1 stays 0.1), 17 otherwise.
+                std::ostringstream sShort;
+                sShort << std::setprecision(15) << dNumber;
+                if (std::strtod(sShort.str().c_str(), nullptr)==dNumber)
+                    s << sShort.str();
+                else
+                    s << std::setprecision(17) << dNumber;
+            }
+            break;
+        case Type::String: s << JsonObject::quote(sString); break;
+        case Type::Boolean: s << (bBoolean?"true":"false"); break;
+        case Type::Array:
+            s << "[";
+            for (std::size_t i=0; i<vArray.size(); ++i)
+                s << (i>0?",":"") << vArray[i].toString();
+            s << "]";
+            break;
+    }
+    return s.str();
+}
+
+JsonObject::JsonObject(const std::string& sText) {
+    JsonParser parser(sText);
+    parser.expect('{');
+    if (!parser.consume('}')) {
+        do {
+            std::string sKey = parser.parseString();
+            parser.expect(':');
+            mValues[sKey] = parser.parseValue();
+        } while (parser.consume(','));
+        parser.expect('}');
+    }
+    if (!parser.atEnd())
+        throw std::string{"Trailing characters after JSON object."};
+}
+
+bool JsonObject::has(const std::string& sKey) const {
+    return mValues.count(sKey)>0;
+}
+
+const JsonValue& JsonObject::get(const std::string& sKey) const {
+    auto it = mValues.find(sKey);
+    if (it==mValues.end())
+        throw std::string{"Missing JSON field \""}+sKey+"\".";
+    return it->second;
+}
+
+double JsonObject::getNumber(const std::string& sKey, double dDefault) const {
+    if (!has(sKey))
+        return dDefault;
+    auto &value = get(sKey);
+    if (value.type!=JsonValue::Type::Number)
+        throw std::string{"JSON field \""}+sKey+"\" must be a number.";
+    return value.dNumber;
+}
+
+std::string JsonObject::getString(const std::string& sKey, const std::string& sDefault) const {
+    if (!has(sKey))
+        return sDefault;
+    auto &value = get(sKey);
+    if (value.type!=JsonValue::Type::String)
+        throw std::string{"JSON field \""}+sKey+"\" must be a string.";
+    return value.sString;
+}
+
+bool JsonObject::getBoolean(const std::string& sKey, bool bDefault) const {
+    if (!has(sKey))
+        return bDefault;
+    auto &value = get(sKey);
+    if (value.type!=JsonValue::Type::Boolean)
+        throw std::string{"JSON field \""}+sKey+"\" must be true or false.";
+    return value.bBoolean;
+}
+
+std::vector<double> JsonObject::getNumbers(const std::string& sKey, const std::vector<double>& vDefault) const {
+    if (!has(sKey))
+        return vDefault;
+    auto &value = get(sKey);
+    if (value.type==JsonValue::Type::Number)
+        return {value.dNumber};
+    if (value.type!=JsonValue::Type::Array)
+        throw std::string{"JSON field \""}+sKey+"\" must be an array of numbers.";
+    std::vector<double> vResult;
+    for (auto &element: value.vArray) {
+        if (element.type!=JsonValue::Type::Number)
+            throw std::string{"JSON field \""}+sKey+"\" must be an array of numbers.";
+        vResult.push_back(element.dNumber);
+    }
+    return vResult;
+}
+
+std::string JsonObject::quote(const std::string& sText) {
+    std::string sResult{"\""};
+    for (char c: sText) {
+        switch (c) {
+            case '"': sResult += "\\\""; break;
+            case '\\': sResult += "\\\\"; break;
+            case '\n': sResult += "\\n"; break;
+            case '\t': sResult += "\\t"; break;
+            case '\r': sResult += "\\r"; break;
+            default:
+                if ((unsigned char)c<0x20)
+                    sResult += ' ';
+                else
+                    sResult += c;
+        }
+    }
+    return sResult+"\"";
+}
@@ -0,0 +1,63 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __JSONOBJECT_H__
+#define __JSONOBJECT_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal JSON support for line based request/response protocols: a single, flat object
+// whose values are numbers, strings, booleans, null or arrays of those. Nested arrays are rejected.
+class JsonValue {
+    public:
+        enum class Type {Null, Number, String, Boolean, Array};
+
+        Type type;
+        double dNumber;
+        std::string sString;
+        bool bBoolean;
+        std::vector<JsonValue> vArray;
+
+        JsonValue(void): type(Type::Null), dNumber(.0), sString(), bBoolean(false), vArray({}) {};
+
+        // Serialized form of the value, e.g. for echoing request ids. Numbers keep their full precision.
+        std::string toString(void) const;
+};
+
+class JsonObject {
+    private:
+        std::map<std::string, JsonValue> mValues;
+    public:
+        // Throws a std::string describing the problem if sText is not a flat JSON object.
+        JsonObject(const std::string& sText);
+        ~JsonObject(void) = default;
+
+        bool has(const std::string& sKey) const;
+        const JsonValue& get(const std::string& sKey) const;
+        double getNumber(const std::string& sKey, double dDefault) const;
+        std::string getString(const std::string& sKey, const std::string& sDefault) const;
+        bool getBoolean(const std::string& sKey, bool bDefault) const;
+        std::vector<double> getNumbers(const std::string& sKey, const std::vector<double>& vDefault) const;
+
+        const std::map<std::string, JsonValue>& getValues(void) const {return mValues;};
+
+        static std::string quote(const std::string& sText);
+};
+
+#endif
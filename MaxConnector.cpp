@@ -15,21 +15,54 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
+#include <cmath>
+
 #include "MaxConnector.h"
+#include "TabulatedObject.h"
+#include "ImportanceSampler.h"
 #include <algorithm>
 
 MaxConnector::MaxConnector(const std::shared_ptr<StochasticObject> &pObject1_, const std::shared_ptr<StochasticObject> &pObject2_) : 
                 pObject1(pObject1_), pObject2(pObject2_) {
 }
 
-double MaxConnector::distributionFunction(double x) const {
-    auto pObject1TooBig = 1.0 - pObject1->distributionFunction(x);
-    auto pObject2TooBig = 1.0 - pObject2->distributionFunction(x);
+double MaxConnector::cdfAt(std::int64_t n) const {
+    return pObject1->cdfAt(n)*pObject2->cdfAt(n);
+}
+
+std::int64_t MaxConnector::getIntMinimum(void) const {
+    return std::max(pObject1->getIntMinimum(), pObject2->getIntMinimum());
+}
 
-    return (1.0 - pObject1TooBig)*(1.0 - pObject2TooBig);
+std::int64_t MaxConnector::sample(ImportanceSampler& sampler) const {
+    auto nFirst = pObject1->sample(sampler);
+    return std::max(nFirst, pObject2->sample(sampler));
 }
 
-double MaxConnector::getMinimum(void) const {
-    return std::max(pObject1->getMinimum(), pObject2->getMinimum());
+std::int64_t MaxConnector::getIntMaximum(void) const {
+    return std::max(pObject1->getIntMaximum(), pObject2->getIntMaximum());
 }
 
+std::string MaxConnector::getDescription(void) const {
+    return "Max("+pObject1->getDescription()+","+pObject2->getDescription()+")";
+}
+
+std::vector<std::shared_ptr<StochasticObject>> MaxConnector::getChildren(void) const {
+    return {pObject1, pObject2};
+}
+
+std::shared_ptr<StochasticObject> MaxConnector::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<MaxConnector>(vChildren.at(0), vChildren.at(1));
+}
+
+std::shared_ptr<TabulatedObject> MaxConnector::tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const {
+    return TabulatedObject::maximum(*vChildren.at(0), *vChildren.at(1), dEpsilon);
+}
+
+StochasticObject::CostEstimate MaxConnector::estimateCost(const std::vector<CostEstimate>& vChildren, double) const {
+    auto &first = vChildren.at(0);
+    auto &second = vChildren.at(1);
+    double dPoints = first.dSupport+second.dSupport;
+    return {std::max(first.dSupport, second.dSupport), 1.+first.dQueryCost+second.dQueryCost,
+            first.dSetupCost+second.dSetupCost, dPoints*(1.+std::log2(dPoints+1.))};
+}
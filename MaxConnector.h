@@ -27,8 +27,15 @@ class MaxConnector: public StochasticObject {
     public:
         MaxConnector(const std::shared_ptr<StochasticObject> &pObject1_, const std::shared_ptr<StochasticObject> &pObject2_);
         virtual ~MaxConnector(void) = default;
-        virtual double distributionFunction(double) const;
-        virtual double getMinimum(void) const;
+        virtual double cdfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+        virtual std::shared_ptr<TabulatedObject> tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const;
+        virtual CostEstimate estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const;
 
 };
 #endif
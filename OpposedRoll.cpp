@@ -0,0 +1,135 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <string>
+#include <algorithm>
+
+#include "FlatMod.h"
+#include "RaiseCounter.h"
+#include "TabulatedObject.h"
+
+#include "OpposedRoll.h"
+#include "ImportanceSampler.h"
+
+OpposedRoll::OpposedRoll(const std::shared_ptr<StochasticObject>& pAttacker_, const std::shared_ptr<StochasticObject>& pDefender_, double dEpsilon_):
+        pAttacker(pAttacker_), pDefender(pDefender_), dEpsilon(dEpsilon_) {
+}
+
+void OpposedRoll::invalidate(void) {
+    std::unique_lock<std::mutex> lock(distributionMutex);
+    pDistribution.reset();
+}
+
+std::shared_ptr<const OpposedRoll::Distribution> OpposedRoll::getDistribution(void) const {
+    std::unique_lock<std::mutex> lock(distributionMutex);
+    if (pDistribution)
+        return pDistribution;
+    TabulatedObject attacker(*pAttacker, dEpsilon);
+    TabulatedObject defender(*pDefender, dEpsilon);
+    // Only the stored runs of either side are correlated, the gaps between them hold no mass.
+    auto vAttacker = attacker.getRuns();
+    auto vDefender = defender.getRuns();
+    std::size_t nAttackerSize = attacker.getSize(), nDefenderSize = defender.getSize();
+
+    // Margin i-j of table positions lands at index i-j+|defender|-1.
+    std::vector<double> vMass(nAttackerSize+nDefenderSize-1, .0);
+    for (auto &attackerRun: vAttacker) {
+        std::size_t nAttackerOffset = std::size_t(attackerRun.first-attacker.getIntMinimum());
+        for (std::size_t i=0; i<attackerRun.second.size(); ++i) {
+            double dAttacker = attackerRun.second[i];
+            if (dAttacker==.0)
+                continue;
+            for (auto &defenderRun: vDefender) {
+                std::size_t nBase = nAttackerOffset+i+nDefenderSize-1-std::size_t(defenderRun.first-defender.getIntMinimum());
+                for (std::size_t j=0; j<defenderRun.second.size(); ++j)
+                    vMass[nBase-j] += dAttacker*defenderRun.second[j];
+            }
+        }
+    }
+    auto pMargin = std::make_shared<Distribution>();
+    pMargin->nMinimum = attacker.getIntMinimum()-(defender.getIntMinimum()+std::int64_t(nDefenderSize)-1);
+    pMargin->vCDF.resize(vMass.size(), .0);
+    double dCDF = .0;
+    for (std::size_t k=0; k<vMass.size(); ++k) {
+        dCDF += vMass[k];
+        pMargin->vCDF[k] = dCDF;
+    }
+    pDistribution = pMargin;
+    return pDistribution;
+}
+
+double OpposedRoll::cdfAt(std::int64_t n) const {
+    auto pMargin = getDistribution();
+    if (n<pMargin->nMinimum)
+        return .0;
+    auto nIndex = std::uint64_t(n)-std::uint64_t(pMargin->nMinimum);
+    if (nIndex>=pMargin->vCDF.size())
+        return 1.;
+    return pMargin->vCDF[nIndex];
+}
+
+std::int64_t OpposedRoll::getIntMinimum(void) const {
+    return getDistribution()->nMinimum;
+}
+
+std::int64_t OpposedRoll::getIntMaximum(void) const {
+    if (pAttacker->getIntMaximum()==nUnbounded)
+        return nUnbounded;
+    return pAttacker->getIntMaximum()-pDefender->getIntMinimum();
+}
+
+// The sides are independent: means subtract and variances add.
+double OpposedRoll::mean(void) const {
+    return pAttacker->mean()-pDefender->mean();
+}
+
+double OpposedRoll::variance(void) const {
+    return pAttacker->variance()+pDefender->variance();
+}
+
+std::int64_t OpposedRoll::sample(ImportanceSampler& sampler) const {
+    auto nAttack = pAttacker->sample(sampler);
+    return addSaturated(nAttack, -pDefender->sample(sampler));
+}
+
+std::string OpposedRoll::getDescription(void) const {
+    return "Opposed("+pAttacker->getDescription()+","+pDefender->getDescription()+")";
+}
+
+std::vector<std::shared_ptr<StochasticObject>> OpposedRoll::getChildren(void) const {
+    return {pAttacker, pDefender};
+}
+
+std::shared_ptr<StochasticObject> OpposedRoll::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<OpposedRoll>(vChildren.at(0), vChildren.at(1), dEpsilon);
+}
+
+std::shared_ptr<StochasticObject> OpposedRoll::countSuccesses(const std::shared_ptr<StochasticObject>& pMargin) {
+    // A margin of 0 counts like a roll of 4 against the usual target number.
+    return std::make_shared<RaiseCounter>(std::make_shared<FlatMod>(pMargin, 4.));
+}
+
+// The first query tabulates both sides and correlates them; later queries are lookups.
+StochasticObject::CostEstimate OpposedRoll::estimateCost(const std::vector<CostEstimate>& vChildren, double) const {
+    auto &attacker = vChildren.at(0);
+    auto &defender = vChildren.at(1);
+    double dPairs = attacker.dSupport*defender.dSupport;
+    return {attacker.dSupport+defender.dSupport, 1.,
+            attacker.dSetupCost+defender.dSetupCost+attacker.dSupport*attacker.dQueryCost+defender.dSupport*defender.dQueryCost+dPairs,
+            attacker.dSupport+defender.dSupport+dPairs};
+}
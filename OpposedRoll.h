@@ -0,0 +1,68 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __OPPOSEDROLL_H__
+#define __OPPOSEDROLL_H__
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "StochasticObject.h"
+
+// Margin attacker - defender of two independent totals. Both sides are tabulated once (up to
+// dEpsilon tail probability) and cross-correlated into the distribution of the margin, so every
+// query afterwards is a table lookup. countSuccesses turns the margin into successes & raises,
+// where meeting the defender's total is a success and every 4 points above it a raise.
+class OpposedRoll: public StochasticObject {
+    private:
+        std::shared_ptr<StochasticObject> pAttacker;
+        std::shared_ptr<StochasticObject> pDefender;
+        double dEpsilon;
+
+        // CDF of the margin from nMinimum on.
+        struct Distribution {
+            std::int64_t nMinimum;
+            std::vector<double> vCDF;
+        };
+        mutable std::mutex distributionMutex;
+        mutable std::shared_ptr<const Distribution> pDistribution;
+
+        // Returned by value, so the table stays valid for the caller even if invalidate runs meanwhile.
+        std::shared_ptr<const Distribution> getDistribution(void) const;
+    public:
+        OpposedRoll(const std::shared_ptr<StochasticObject>& pAttacker_, const std::shared_ptr<StochasticObject>& pDefender_, double dEpsilon_=1e-12);
+        virtual ~OpposedRoll(void) = default;
+
+        virtual double cdfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+        virtual CostEstimate estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const;
+
+        // Drops the cached distribution, call it after modifying either side.
+        void invalidate(void);
+
+        static std::shared_ptr<StochasticObject> countSuccesses(const std::shared_ptr<StochasticObject>& pMargin);
+};
+
+#endif
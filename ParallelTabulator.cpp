@@ -0,0 +1,229 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "ParallelTabulator.h"
+
+namespace {
+    struct TabulationNode {
+        std::shared_ptr<StochasticObject> pObject;
+        std::vector<std::size_t> vChildren;
+        std::vector<std::size_t> vParents;
+        std::atomic<std::size_t> nPending;
+        bool bSerial;
+        std::shared_ptr<TabulatedObject> pTable;
+    };
+
+    struct TabulationJob {
+        std::vector<std::unique_ptr<TabulationNode>> vNodes;
+        std::mutex mutex;
+        std::condition_variable cvDone;
+        bool bDone;
+        std::exception_ptr pError;
+    };
+
+    // Distinct objects below pRoot with children before their parents, by an iterative depth-first
+    // search. children(pObject) lists the children to descend into.
+    template<typename Children>
+    std::vector<std::shared_ptr<StochasticObject>> postOrder(const std::shared_ptr<StochasticObject>& pRoot, Children children) {
+        std::vector<std::shared_ptr<StochasticObject>> vOrder;
+        std::map<const StochasticObject*, bool> mSeen;
+        std::vector<std::pair<std::pair<std::shared_ptr<StochasticObject>, std::vector<std::shared_ptr<StochasticObject>>>, std::size_t>> vStack;
+        mSeen[pRoot.get()] = true;
+        vStack.push_back({{pRoot, children(pRoot)}, 0});
+        while (!vStack.empty()) {
+            auto &top = vStack.back();
+            if (top.second<top.first.second.size()) {
+                auto pChild = top.first.second[top.second++];
+                if (!mSeen[pChild.get()]) {
+                    mSeen[pChild.get()] = true;
+                    vStack.push_back({{pChild, children(pChild)}, 0});
+                }
+                continue;
+            }
+            vOrder.push_back(top.first.first);
+            vStack.pop_back();
+        }
+        return vOrder;
+    }
+
+    std::size_t addSaturated(std::size_t nLeft, std::size_t nRight) {
+        return nLeft>std::numeric_limits<std::size_t>::max()-nRight ? std::numeric_limits<std::size_t>::max() : nLeft+nRight;
+    }
+}
+
+ParallelTabulator::ParallelTabulator(double dEpsilon_, std::size_t nSerialThreshold_, const std::shared_ptr<WorkStealingPool>& pPool_):
+        dEpsilon(dEpsilon_), nSerialThreshold(nSerialThreshold_), pPool(pPool_) {
+}
+
+std::size_t ParallelTabulator::countSubtree(const std::shared_ptr<StochasticObject>& pObject, std::map<const StochasticObject*, std::size_t>& mSizes) {
+    auto it = mSizes.find(pObject.get());
+    if (it!=mSizes.end())
+        return it->second;
+    auto vOrder = postOrder(pObject, [&mSizes](const std::shared_ptr<StochasticObject>& pNode) {
+        std::vector<std::shared_ptr<StochasticObject>> vChildren;
+        for (auto &pChild: pNode->getChildren())
+            if (!mSizes.count(pChild.get()))
+                vChildren.push_back(pChild);
+        return vChildren;
+    });
+    for (auto &pNode: vOrder) {
+        std::size_t nCount = 1;
+        for (auto &pChild: pNode->getChildren())
+            nCount = addSaturated(nCount, mSizes.at(pChild.get()));
+        mSizes[pNode.get()] = nCount;
+    }
+    return mSizes.at(pObject.get());
+}
+
+std::size_t ParallelTabulator::countNodes(const StochasticObject& object) {
+    std::map<const StochasticObject*, std::size_t> mSizes;
+    std::size_t nCount = 1;
+    for (auto &pChild: object.getChildren())
+        nCount = addSaturated(nCount, countSubtree(pChild, mSizes));
+    return nCount;
+}
+
+std::shared_ptr<TabulatedObject> ParallelTabulator::tabulateSerially(const std::shared_ptr<StochasticObject>& pObject, double dEpsilon,
+        std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>>& mDone) {
+    auto it = mDone.find(pObject.get());
+    if (it!=mDone.end())
+        return it->second;
+    auto vOrder = postOrder(pObject, [&mDone](const std::shared_ptr<StochasticObject>& pNode) {
+        std::vector<std::shared_ptr<StochasticObject>> vChildren;
+        if (!pNode->canTabulateDirectly())
+            for (auto &pChild: pNode->getChildren())
+                if (!mDone.count(pChild.get()))
+                    vChildren.push_back(pChild);
+        return vChildren;
+    });
+    for (auto &pNode: vOrder) {
+        auto vChildren = pNode->getChildren();
+        std::shared_ptr<TabulatedObject> pTable;
+        if (pNode->canTabulateDirectly()) {
+            pTable = pNode->tabulateDirectly(dEpsilon);
+        } else if (vChildren.empty()) {
+            pTable = std::make_shared<TabulatedObject>(*pNode, dEpsilon);
+        } else {
+            std::vector<std::shared_ptr<TabulatedObject>> vTabulatedChildren;
+            for (auto &pChild: vChildren)
+                vTabulatedChildren.push_back(mDone.at(pChild.get()));
+            pTable = pNode->tabulateOver(vTabulatedChildren, dEpsilon);
+        }
+        mDone[pNode.get()] = pTable;
+    }
+    return mDone.at(pObject.get());
+}
+
+std::shared_ptr<TabulatedObject> ParallelTabulator::tabulate(const std::shared_ptr<StochasticObject>& pRoot) const {
+    // Subtree sizes are computed once; shared objects count once per path, as in countNodes.
+    std::map<const StochasticObject*, std::size_t> mSizes;
+    if (countSubtree(pRoot, mSizes)<nSerialThreshold || pPool->getThreadCount()<2) {
+        std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>> mDone;
+        return tabulateSerially(pRoot, dEpsilon, mDone);
+    }
+
+    auto pJob = std::make_shared<TabulationJob>();
+    pJob->bDone = false;
+    std::map<const StochasticObject*, bool> mSerial;
+    auto isSerial = [&](const std::shared_ptr<StochasticObject>& pObject) {
+        auto it = mSerial.find(pObject.get());
+        if (it!=mSerial.end())
+            return it->second;
+        return mSerial[pObject.get()] = mSizes.at(pObject.get())<nSerialThreshold || pObject->canTabulateDirectly();
+    };
+    auto vOrder = postOrder(pRoot, [&](const std::shared_ptr<StochasticObject>& pObject) {
+        return isSerial(pObject) ? std::vector<std::shared_ptr<StochasticObject>>{} : pObject->getChildren();
+    });
+    std::map<const StochasticObject*, std::size_t> mIndex;
+    for (auto &pObject: vOrder) {
+        std::size_t nIndex = pJob->vNodes.size();
+        mIndex[pObject.get()] = nIndex;
+        pJob->vNodes.push_back(std::make_unique<TabulationNode>());
+        auto &node = *pJob->vNodes[nIndex];
+        node.pObject = pObject;
+        node.bSerial = isSerial(pObject);
+        if (!node.bSerial) {
+            for (auto &pChild: pObject->getChildren()) {
+                auto nChild = mIndex.at(pChild.get());
+                node.vChildren.push_back(nChild);
+                pJob->vNodes[nChild]->vParents.push_back(nIndex);
+            }
+        }
+        node.nPending = node.vChildren.size();
+    }
+    std::size_t nRoot = mIndex.at(pRoot.get());
+
+    auto pPoolCopy = pPool;
+    double dEpsilonCopy = dEpsilon;
+    std::shared_ptr<std::function<void(std::size_t)>> pRun = std::make_shared<std::function<void(std::size_t)>>();
+    std::weak_ptr<std::function<void(std::size_t)>> pWeakRun = pRun;
+    *pRun = [pJob, pPoolCopy, pWeakRun, nRoot, dEpsilonCopy](std::size_t nIndex) {
+        auto &node = *pJob->vNodes[nIndex];
+        try {
+            {
+                std::unique_lock<std::mutex> lock(pJob->mutex);
+                if (pJob->bDone)
+                    return;
+            }
+            if (node.bSerial) {
+                std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>> mDone;
+                node.pTable = tabulateSerially(node.pObject, dEpsilonCopy, mDone);
+            } else {
+                std::vector<std::shared_ptr<TabulatedObject>> vTabulatedChildren;
+                for (auto nChild: node.vChildren)
+                    vTabulatedChildren.push_back(pJob->vNodes[nChild]->pTable);
+                node.pTable = node.pObject->tabulateOver(vTabulatedChildren, dEpsilonCopy);
+            }
+        } catch (...) {
+            std::unique_lock<std::mutex> lock(pJob->mutex);
+            pJob->pError = std::current_exception();
+            pJob->bDone = true;
+            pJob->cvDone.notify_all();
+            return;
+        }
+        if (nIndex==nRoot) {
+            std::unique_lock<std::mutex> lock(pJob->mutex);
+            pJob->bDone = true;
+            pJob->cvDone.notify_all();
+            return;
+        }
+        auto pRunParent = pWeakRun.lock();
+        if (!pRunParent)
+            return;
+        for (auto nParent: node.vParents)
+            if (--pJob->vNodes[nParent]->nPending==0)
+                pPoolCopy->submit([pRunParent, nParent](){(*pRunParent)(nParent);});
+    };
+
+    for (std::size_t i=0; i<pJob->vNodes.size(); ++i)
+        if (pJob->vNodes[i]->vChildren.empty())
+            pPool->submit([pRun, i](){(*pRun)(i);});
+
+    std::unique_lock<std::mutex> lock(pJob->mutex);
+    pJob->cvDone.wait(lock, [&pJob](){return pJob->bDone;});
+    if (pJob->pError)
+        std::rethrow_exception(pJob->pError);
+    return pJob->vNodes[nRoot]->pTable;
+}
@@ -0,0 +1,54 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __PARALLELTABULATOR_H__
+#define __PARALLELTABULATOR_H__
+
+#include <cstddef>
+#include <map>
+#include <memory>
+
+#include "StochasticObject.h"
+#include "TabulatedObject.h"
+#include "WorkStealingPool.h"
+
+// Tabulates an object tree bottom-up: every node is tabulated from the tables of its children
+// (see StochasticObject::tabulateOver). Independent subtrees are tabulated concurrently on a
+// WorkStealingPool; a node is scheduled once all of its children are done. Subtrees with fewer than
+// nSerialThreshold nodes are handled serially within a single task. Objects shared between several
+// parents are tabulated once. Subtrees that can be tabulated directly (canTabulateDirectly) are one task.
+class ParallelTabulator {
+    private:
+        double dEpsilon;
+        std::size_t nSerialThreshold;
+        std::shared_ptr<WorkStealingPool> pPool;
+
+        static std::shared_ptr<TabulatedObject> tabulateSerially(const std::shared_ptr<StochasticObject>& pObject, double dEpsilon,
+                std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>>& mDone);
+        // Nodes below pObject, counting shared objects once per path; sizes are memoized in mSizes.
+        static std::size_t countSubtree(const std::shared_ptr<StochasticObject>& pObject, std::map<const StochasticObject*, std::size_t>& mSizes);
+    public:
+        ParallelTabulator(double dEpsilon_=1e-9, std::size_t nSerialThreshold_=4,
+                          const std::shared_ptr<WorkStealingPool>& pPool_=WorkStealingPool::getDefault());
+        ~ParallelTabulator(void) = default;
+
+        std::shared_ptr<TabulatedObject> tabulate(const std::shared_ptr<StochasticObject>& pRoot) const;
+
+        static std::size_t countNodes(const StochasticObject& object);
+};
+
+#endif
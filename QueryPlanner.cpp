@@ -0,0 +1,180 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "ImportanceSampler.h"
+#include "QueryPlanner.h"
+
+namespace {
+    const double dInfinity = std::numeric_limits<double>::infinity();
+    // Drawing a sample costs a few operations (random numbers, explosions) per node.
+    const double dSampleCostPerNode = 4.;
+    const std::size_t nMaxSamples = 100000000;
+}
+
+QueryPlanner::QueryPlanner(double dEpsilon_, double dQueries_, double dTolerance_): dEpsilon(dEpsilon_), dQueries(std::max(dQueries_, .0)),
+        dTolerance(dTolerance_), nSamples(0) {
+    // Two standard errors of a sampled probability stay below dTolerance.
+    if (dTolerance>.0)
+        nSamples = std::size_t(std::min(double(nMaxSamples), std::ceil(1./(dTolerance*dTolerance))));
+}
+
+const char* QueryPlanner::getStrategyName(Strategy strategy) {
+    switch (strategy) {
+        case Strategy::Direct: return "direct";
+        case Strategy::Walk: return "walk";
+        case Strategy::Combine: return "combine";
+        case Strategy::Sample: return "sample";
+    }
+    return "";
+}
+
+std::shared_ptr<QueryPlanner::PlanNode> QueryPlanner::planNode(const std::shared_ptr<StochasticObject>& pObject,
+        std::map<const StochasticObject*, std::shared_ptr<PlanNode>>& mNodes) const {
+    // Leaves are measured by tabulating them, so shared objects are only planned once.
+    auto it = mNodes.find(pObject.get());
+    if (it!=mNodes.end())
+        return it->second;
+    auto pNode = std::make_shared<PlanNode>();
+    pNode->pObject = pObject;
+    pNode->dNodeCount = 1.;
+    std::vector<StochasticObject::CostEstimate> vChildEstimates;
+    double dChildTables = .0;
+    for (auto &pChild: pObject->getChildren()) {
+        pNode->vChildren.push_back(planNode(pChild, mNodes));
+        vChildEstimates.push_back(pNode->vChildren.back()->estimate);
+        // A child used twice is tabulated once.
+        if (std::find(pNode->vChildren.begin(), pNode->vChildren.end()-1, pNode->vChildren.back())==pNode->vChildren.end()-1)
+            dChildTables += pNode->vChildren.back()->dTableCost;
+        pNode->dNodeCount += pNode->vChildren.back()->dNodeCount;
+    }
+    pNode->estimate = pObject->estimateCost(vChildEstimates, dEpsilon);
+
+    pNode->dWalkCost = pNode->estimate.dSetupCost+pNode->estimate.dSupport*pNode->estimate.dQueryCost;
+    // Subtrees with a closed form are combined without child tables.
+    bool bDirectTable = pObject->canTabulateDirectly();
+    if (bDirectTable)
+        pNode->dCombineCost = pNode->estimate.dCombineCost;
+    else
+        pNode->dCombineCost = pNode->vChildren.empty() ? dInfinity : dChildTables+pNode->estimate.dCombineCost;
+    pNode->dSampleCost = nSamples>0 ? double(nSamples)*pNode->dNodeCount*dSampleCostPerNode : dInfinity;
+    pNode->strategy = Strategy::Walk;
+    pNode->dTableCost = pNode->dWalkCost;
+    if (pNode->dCombineCost<pNode->dTableCost) {
+        pNode->strategy = Strategy::Combine;
+        pNode->dTableCost = pNode->dCombineCost;
+    }
+    if (pNode->dSampleCost<pNode->dTableCost) {
+        pNode->strategy = Strategy::Sample;
+        pNode->dTableCost = pNode->dSampleCost;
+    }
+    mNodes[pObject.get()] = pNode;
+    return pNode;
+}
+
+QueryPlanner::Plan QueryPlanner::plan(const std::shared_ptr<StochasticObject>& pRoot, bool bNeedTable) const {
+    Plan result;
+    std::map<const StochasticObject*, std::shared_ptr<PlanNode>> mNodes;
+    result.pRoot = planNode(pRoot, mNodes);
+    result.dEpsilon = dEpsilon;
+    result.dQueries = dQueries;
+    result.nSamples = nSamples;
+    auto &root = *result.pRoot;
+    result.dDirectCost = bNeedTable ? dInfinity : root.estimate.dSetupCost+dQueries*root.estimate.dQueryCost;
+    // Lookups in a table are binary searches over its runs.
+    result.dCost = root.dTableCost+dQueries*(1.+std::log2(root.estimate.dSupport+1.));
+    if (result.dDirectCost<result.dCost) {
+        root.strategy = Strategy::Direct;
+        result.dCost = result.dDirectCost;
+    }
+    return result;
+}
+
+std::shared_ptr<StochasticObject> QueryPlanner::Plan::execute(void) const {
+    std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>> mDone;
+    return execute(*pRoot, mDone);
+}
+
+std::shared_ptr<StochasticObject> QueryPlanner::Plan::execute(const PlanNode& node,
+        std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>>& mDone) const {
+    if (node.strategy==Strategy::Direct)
+        return node.pObject;
+    auto it = mDone.find(node.pObject.get());
+    if (it!=mDone.end())
+        return it->second;
+    std::shared_ptr<TabulatedObject> pTable;
+    if (node.strategy==Strategy::Walk) {
+        pTable = std::make_shared<TabulatedObject>(*node.pObject, dEpsilon);
+    } else if (node.strategy==Strategy::Combine && node.pObject->canTabulateDirectly()) {
+        pTable = node.pObject->tabulateDirectly(dEpsilon);
+    } else if (node.strategy==Strategy::Combine) {
+        std::vector<std::shared_ptr<TabulatedObject>> vTables;
+        for (auto &pChild: node.vChildren)
+            vTables.push_back(std::static_pointer_cast<TabulatedObject>(execute(*pChild, mDone)));
+        pTable = node.pObject->tabulateOver(vTables, dEpsilon);
+    } else {
+        ImportanceSampler sampler;
+        std::map<std::int64_t, std::size_t> mCounts;
+        for (std::size_t i=0; i<nSamples; ++i)
+            ++mCounts[node.pObject->sample(sampler)];
+        std::vector<double> vMass(std::size_t(mCounts.rbegin()->first-mCounts.begin()->first)+1, .0);
+        for (auto &count: mCounts)
+            vMass[std::size_t(count.first-mCounts.begin()->first)] = double(count.second)/double(nSamples);
+        pTable = std::make_shared<TabulatedObject>(double(mCounts.begin()->first), vMass);
+    }
+    mDone[node.pObject.get()] = pTable;
+    return pTable;
+}
+
+std::string QueryPlanner::Plan::explain(void) const {
+    std::ostringstream s;
+    s << std::setprecision(3);
+    s << "Plan for queries: "<<dQueries<<", epsilon: "<<dEpsilon;
+    if (nSamples>0)
+        s << " ("<<nSamples<<" samples if sampled)";
+    s << ", estimated cost "<<dCost<<" (direct "<<dDirectCost<<")\n";
+    std::map<const PlanNode*, bool> mShown;
+    explain(*pRoot, true, 0, mShown, s);
+    return s.str();
+}
+
+void QueryPlanner::Plan::explain(const PlanNode& node, bool bEvaluated, std::size_t nDepth, std::map<const PlanNode*, bool>& mShown,
+        std::ostream& output) const {
+    auto sDescription = node.pObject->getDescription();
+    output << std::string(2*nDepth, ' ') << sDescription.substr(0, sDescription.find('(')) << ": ";
+    if (bEvaluated)
+        output << getStrategyName(node.strategy);
+    else
+        output << "queried by parent";
+    // Shared nodes are listed once.
+    if (mShown[&node]) {
+        output << " (shared, see above)\n";
+        return;
+    }
+    mShown[&node] = true;
+    output << " (support "<<node.estimate.dSupport<<", query "<<node.estimate.dQueryCost<<", walk "<<node.dWalkCost
+           << ", combine "<<node.dCombineCost<<", sample "<<node.dSampleCost<<")\n";
+    bool bChildrenEvaluated = bEvaluated && node.tabulatesChildren();
+    for (auto &pChild: node.vChildren)
+        explain(*pChild, bChildrenEvaluated, nDepth+1, mShown, output);
+}
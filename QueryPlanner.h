@@ -0,0 +1,97 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __QUERYPLANNER_H__
+#define __QUERYPLANNER_H__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "StochasticObject.h"
+#include "TabulatedObject.h"
+
+// Chooses per node how an object tree is evaluated, from the cost estimates of the nodes
+// (StochasticObject::estimateCost), the expected number of queries and the accuracy needed:
+//   Direct  - answer every query by recursing through the tree; cheap for a few queries on shallow trees
+//   Walk    - tabulate the node by querying it value by value; the closed form for leaves like dice
+//   Combine - tabulate the children first and combine their tables (e.g. convolution for sums), or use the
+//             closed form of the node where it has one (canTabulateDirectly), e.g. sums of exploding dice
+//   Sample  - tabulate a histogram of random samples; only with a nonzero tolerance
+// Only the root can be Direct. Children of Direct, Walk and Sample nodes are not tabulated themselves.
+// Objects shared by several parents are planned once and share their PlanNode.
+class QueryPlanner {
+    public:
+        enum class Strategy {Direct, Walk, Combine, Sample};
+        struct PlanNode {
+            std::shared_ptr<StochasticObject> pObject;
+            Strategy strategy;
+            StochasticObject::CostEstimate estimate;
+            double dWalkCost;
+            double dCombineCost;
+            double dSampleCost;
+            double dTableCost; // cheapest way to a table of this node
+            double dNodeCount; // nodes below and including this one, shared ones once per path
+            std::vector<std::shared_ptr<const PlanNode>> vChildren;
+            // Whether the children are tabulated for this node rather than queried through it.
+            bool tabulatesChildren(void) const {return strategy==Strategy::Combine && !pObject->canTabulateDirectly();};
+        };
+        class Plan {
+            private:
+                std::shared_ptr<PlanNode> pRoot;
+                double dEpsilon;
+                double dQueries;
+                std::size_t nSamples;
+                double dDirectCost;
+                double dCost;
+
+                std::shared_ptr<StochasticObject> execute(const PlanNode& node, std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>>& mDone) const;
+                void explain(const PlanNode& node, bool bEvaluated, std::size_t nDepth, std::map<const PlanNode*, bool>& mShown, std::ostream& output) const;
+                friend class QueryPlanner;
+            public:
+                // Evaluates the plan. The result is the root itself for a Direct plan, otherwise a table.
+                std::shared_ptr<StochasticObject> execute(void) const;
+                // One line per node with the chosen strategy and the estimated costs of the alternatives.
+                std::string explain(void) const;
+
+                Strategy getStrategy(void) const {return pRoot->strategy;};
+                double getEstimatedCost(void) const {return dCost;};
+        };
+    private:
+        double dEpsilon;
+        double dQueries;
+        double dTolerance;
+        std::size_t nSamples;
+
+        std::shared_ptr<PlanNode> planNode(const std::shared_ptr<StochasticObject>& pObject,
+                std::map<const StochasticObject*, std::shared_ptr<PlanNode>>& mNodes) const;
+    public:
+        // dQueries_ is the number of cdfAt/pmfAt calls expected on the result. dTolerance_ is the absolute
+        // error allowed on probabilities; 0 rules out sampling.
+        QueryPlanner(double dEpsilon_=1e-9, double dQueries_=1., double dTolerance_=.0);
+        ~QueryPlanner(void) = default;
+
+        // bNeedTable rules out a Direct root, e.g. when the whole distribution is wanted.
+        Plan plan(const std::shared_ptr<StochasticObject>& pRoot, bool bNeedTable=false) const;
+
+        static const char* getStrategyName(Strategy strategy);
+};
+
+#endif
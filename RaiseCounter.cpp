@@ -16,20 +16,58 @@ You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include "RaiseCounter.h"
+#include "ImportanceSampler.h"
 
 #include <cmath>
 
 RaiseCounter::RaiseCounter(const std::shared_ptr<StochasticObject>& pObject_): pObject(pObject_) {
 }
 
-double RaiseCounter::distributionFunction(double dX) const {
-    if(dX<0)
+double RaiseCounter::cdfAt(std::int64_t n) const {
+    if(n<0)
         return .0;
-    double dIntegerPartOfX{.0};
-    std::modf(dX, &dIntegerPartOfX);
-    return pObject->distributionFunction(dIntegerPartOfX*4.0 + 3.0);
+    if(n>(nUnbounded-3)/4)
+        return 1.;
+    return pObject->cdfAt(n*4 + 3);
 }
 
-double RaiseCounter::getMinimum(void) const {
-    return .0;
+std::int64_t RaiseCounter::getIntMinimum(void) const {
+    return 0;
+}
+
+std::int64_t RaiseCounter::sample(ImportanceSampler& sampler) const {
+    // Smallest count n with sample <= 4n+3.
+    auto nRoll = pObject->sample(sampler);
+    if (nRoll<=3)
+        return 0;
+    return nRoll/4;
+}
+
+std::int64_t RaiseCounter::getIntMaximum(void) const {
+    auto nMaximum = pObject->getIntMaximum();
+    if (nMaximum==nUnbounded)
+        return nUnbounded;
+    if (nMaximum<=3)
+        return 0;
+    return nMaximum/4;
+}
+
+std::string RaiseCounter::getDescription(void) const {
+    return "RaiseCounter("+pObject->getDescription()+")";
+}
+
+std::vector<std::shared_ptr<StochasticObject>> RaiseCounter::getChildren(void) const {
+    return {pObject};
+}
+
+std::shared_ptr<StochasticObject> RaiseCounter::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<RaiseCounter>(vChildren.at(0));
+}
+
+// One count per four values of the roll.
+StochasticObject::CostEstimate RaiseCounter::estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const {
+    auto estimate = StochasticObject::estimateCost(vChildren, dEpsilon);
+    estimate.dSupport = vChildren.at(0).dSupport/4.+1.;
+    estimate.dCombineCost = vChildren.at(0).dSupport+estimate.dSupport;
+    return estimate;
 }
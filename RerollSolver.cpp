@@ -0,0 +1,111 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <algorithm>
+
+#include "RerollSolver.h"
+
+RerollSolver::RerollSolver(const SWTraitRoll& roll, unsigned int nBennies_, const Utility& utility, double dEpsilon):
+        nBennies(nBennies_), nTopLevel(0), dCriticalFailure(.0), dExpectedUtility(.0) {
+    SWTraitRoll singleRoll(roll);
+    singleRoll.setRerolls(0);
+    TabulatedObject table(singleRoll, dEpsilon);
+    // Outcomes beyond the table are lumped into the top level, which keeps less than dEpsilon probability.
+    nTopLevel = std::max<std::int64_t>(table.getIntMaximum(), 0);
+    if (nTopLevel>(1<<16))
+        throw std::string{"RerollSolver needs a trait roll with fewer than 2^16 outcome levels."};
+    dCriticalFailure = table.pmfAt(-1);
+    vLevelProbability.assign(std::size_t(nTopLevel)+1, .0);
+    for (std::int64_t n=0; n<=nTopLevel; ++n)
+        vLevelProbability[std::size_t(n)] = table.pmfAt(n);
+    solve(utility);
+    computeOutcome();
+}
+
+void RerollSolver::solve(const Utility& utility) {
+    std::size_t nLevels = std::size_t(nTopLevel)+1;
+    std::vector<double> vUtility(nLevels);
+    for (std::size_t s=0; s<nLevels; ++s)
+        vUtility[s] = utility(std::int64_t(s));
+    double dCriticalUtility = utility(-1);
+
+    // vValue[b][s]: expected utility with b bennies left and best outcome s, playing optimally.
+    vValue.assign(nBennies+1, vUtility);
+    vReroll.assign(nBennies+1, std::vector<bool>(nLevels, false));
+    for (unsigned int b=1; b<=nBennies; ++b) {
+        auto &vNext = vValue[b-1];
+        // Rolling L below the best s keeps s, so accumulate that probability from the bottom.
+        double dBelow = .0;
+        for (std::size_t s=0; s<nLevels; ++s) {
+            dBelow += vLevelProbability[s];
+            double dReroll = dCriticalUtility*dCriticalFailure + dBelow*vNext[s];
+            for (std::size_t l=s+1; l<nLevels; ++l)
+                dReroll += vLevelProbability[l]*vNext[l];
+            // Only spend a benny if it strictly helps.
+            if (dReroll>vUtility[s]) {
+                vValue[b][s] = dReroll;
+                vReroll[b][s] = true;
+            }
+        }
+    }
+    dExpectedUtility = dCriticalUtility*dCriticalFailure;
+    for (std::size_t l=0; l<nLevels; ++l)
+        dExpectedUtility += vLevelProbability[l]*vValue[nBennies][l];
+}
+
+void RerollSolver::computeOutcome(void) {
+    std::size_t nLevels = std::size_t(nTopLevel)+1;
+    // Index 0 is critical failure, index s+1 final outcome s.
+    std::vector<double> vFinal(nLevels+1, .0);
+    vFinal[0] = dCriticalFailure;
+    std::vector<double> vState = vLevelProbability;
+    for (unsigned int b=nBennies; ; --b) {
+        std::vector<double> vNextState(nLevels, .0);
+        for (std::size_t s=0; s<nLevels; ++s) {
+            if (vState[s]==.0)
+                continue;
+            if (!vReroll[b][s]) {
+                vFinal[s+1] += vState[s];
+                continue;
+            }
+            vFinal[0] += vState[s]*dCriticalFailure;
+            for (std::size_t l=0; l<nLevels; ++l)
+                vNextState[std::max(s, l)] += vState[s]*vLevelProbability[l];
+        }
+        if (b==0)
+            break;
+        vState = vNextState;
+    }
+    pOutcome = std::make_shared<TabulatedObject>(-1., vFinal);
+}
+
+bool RerollSolver::shouldReroll(unsigned int nBenniesLeft, std::int64_t nBest) const {
+    if (nBenniesLeft==0 || nBest<0)
+        return false;
+    nBenniesLeft = std::min(nBenniesLeft, nBennies);
+    nBest = std::min(nBest, nTopLevel);
+    return vReroll[nBenniesLeft][std::size_t(nBest)];
+}
+
+RerollSolver::Utility RerollSolver::atLeast(std::int64_t nLevel) {
+    return [nLevel](std::int64_t n){return n>=nLevel?1.:.0;};
+}
+
+RerollSolver::Utility RerollSolver::successesAndRaises(void) {
+    return [](std::int64_t n){return n>0?double(n):.0;};
+}
@@ -0,0 +1,69 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __REROLLSOLVER_H__
+#define __REROLLSOLVER_H__
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "SWTraitRoll.h"
+#include "TabulatedObject.h"
+
+// Optimal benny spending for a trait roll. After every roll the player either keeps the best result so
+// far or spends a benny on another roll; a critical failure on any roll ends the attempt as critical
+// failure. The solver runs a dynamic program over (bennies left, best outcome so far) on the tabulated
+// outcome of a single roll, which takes O(nBennies * nLevels^2) steps.
+//
+// The goal is a utility per outcome level (-1 critical failure, 0 failure, 1 success, 2 one raise...),
+// e.g. atLeast(2) to maximize the chance of a raise or successesAndRaises() for the expected count.
+class RerollSolver {
+    public:
+        typedef std::function<double(std::int64_t)> Utility;
+    private:
+        unsigned int nBennies;
+        std::int64_t nTopLevel;
+        double dCriticalFailure;
+        std::vector<double> vLevelProbability;
+        std::vector<std::vector<double>> vValue;
+        std::vector<std::vector<bool>> vReroll;
+        double dExpectedUtility;
+        std::shared_ptr<TabulatedObject> pOutcome;
+
+        void solve(const Utility& utility);
+        void computeOutcome(void);
+    public:
+        // The rerolls set on roll are ignored, nBennies_ takes their place.
+        RerollSolver(const SWTraitRoll& roll, unsigned int nBennies_, const Utility& utility, double dEpsilon=1e-12);
+        ~RerollSolver(void) = default;
+
+        // Whether to spend a benny with nBenniesLeft when the best outcome so far is nBest (0 or higher).
+        bool shouldReroll(unsigned int nBenniesLeft, std::int64_t nBest) const;
+        // Policy table indexed by [bennies left][best outcome so far], outcomes from 0 to getTopLevel().
+        const std::vector<std::vector<bool>>& getPolicy(void) const {return vReroll;};
+        std::int64_t getTopLevel(void) const {return nTopLevel;};
+        double getExpectedUtility(void) const {return dExpectedUtility;};
+        // Distribution of the final outcome level when following the policy.
+        std::shared_ptr<TabulatedObject> getOutcome(void) const {return pOutcome;};
+
+        static Utility atLeast(std::int64_t nLevel);
+        static Utility successesAndRaises(void);
+};
+
+#endif
@@ -0,0 +1,345 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <sstream>
+#include <iomanip>
+
+#include "SWTraitRoll.h"
+#include "ParallelTabulator.h"
+#include "QueryPlanner.h"
+
+#include "RollServer.h"
+
+namespace {
+    const std::size_t nLatencyWindow = 10000;
+    const std::size_t nMaxSweepSize = 10000;
+    const std::size_t nMaxTables = 4096;
+    const std::size_t nMaxPipelines = 256;
+    const std::size_t nMaxExpressions = 256;
+
+    // Same limits as BatchProcessor::parseQuery.
+    const long long nMaxSides = 1000;
+    const long long nMaxMod = 1000;
+    const long long nMaxRerolls = 100;
+    const long long nMaxToughness = 1000;
+    const std::size_t nMaxDamageDice = 100;
+
+    // Rejects nan, infinities, fractions and values outside [nMinimum, nMaximum].
+    long long toBoundedInteger(double dValue, const std::string& sField, long long nMinimum, long long nMaximum) {
+        if (!(dValue>=double(nMinimum) && dValue<=double(nMaximum)) || dValue!=std::floor(dValue))
+            throw std::string{"\""}+sField+"\" must be an integer from "+std::to_string(nMinimum)+" to "+std::to_string(nMaximum)+".";
+        return (long long)dValue;
+    }
+
+    unsigned int toSides(double dValue, const std::string& sField) {
+        return (unsigned int)toBoundedInteger(dValue, sField, 0, nMaxSides);
+    }
+}
+
+RollServer::RollServer(const std::shared_ptr<DistributionCache>& pDiskCache_, double dEpsilon_):
+        dEpsilon(dEpsilon_), pDiskCache(pDiskCache_), mTables(nMaxTables), mPipelines(nMaxPipelines),
+        mExpressions(nMaxExpressions), nRequests(0), nCacheHits(0), nCacheMisses(0),
+        vLatencies({}), nLatencyPos(0) {
+}
+
+std::shared_ptr<TabulatedObject> RollServer::getTable(const std::string& sKey, const std::function<std::shared_ptr<TabulatedObject>(void)>& compute) {
+    std::promise<std::shared_ptr<TabulatedObject>> promise;
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        if (auto pFuture = mTables.find(sKey)) {
+            ++nCacheHits;
+            auto future = *pFuture;
+            lock.unlock();
+            return future.get();
+        }
+        ++nCacheMisses;
+        mTables[sKey] = promise.get_future().share();
+    }
+    try {
+        auto pTable = compute();
+        promise.set_value(pTable);
+        return pTable;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        mTables.erase(sKey);
+        throw;
+    }
+}
+
+std::string RollServer::formatTable(const TabulatedObject& table) {
+    std::ostringstream s;
+    s << std::setprecision(12);
+    s << "\"mean\":"<<table.mean()<<",\"variance\":"<<table.variance();
+    s << ",\"minimum\":"<<table.getIntMinimum()<<",\"pmf\":[";
+    // Straight from the stored runs; the gaps between them are written as zeros.
+    std::int64_t nNext = table.getIntMinimum();
+    for (auto &run: table.getRuns()) {
+        for (; nNext<run.first; ++nNext)
+            s << (nNext>table.getIntMinimum()?",":"") << 0;
+        for (auto dMass: run.second)
+            s << (nNext++>table.getIntMinimum()?",":"") << dMass;
+    }
+    s << "]";
+    return s.str();
+}
+
+std::string RollServer::answerTrait(const JsonObject& request) {
+    auto nDie = toSides(request.getNumber("die", 4.), "die");
+    auto nWild = toSides(request.getNumber("wild", 6.), "wild");
+    int nMod = int(toBoundedInteger(request.getNumber("mod", 0.), "mod", -nMaxMod, nMaxMod));
+    auto nRerolls = (unsigned int)toBoundedInteger(request.getNumber("rerolls", 0.), "rerolls", 0, nMaxRerolls);
+    if (nDie<=1 || nWild<=1)
+        throw std::string{"Trait and Wild Die need more than one side."};
+    std::ostringstream sKey;
+    sKey << "trait/"<<nDie<<"/"<<nWild<<"/"<<nMod<<"/"<<nRerolls;
+    auto pTable = getTable(sKey.str(), [&](){
+        SWTraitRoll traitRoll(nDie, nWild, nMod, nRerolls);
+        if (pDiskCache)
+            return pDiskCache->getTabulated(traitRoll, dEpsilon);
+        return std::make_shared<TabulatedObject>(traitRoll, dEpsilon);
+    });
+    return formatTable(*pTable);
+}
+
+std::string RollServer::answerAttack(const JsonObject& request) {
+    auto nAttackDie = toSides(request.getNumber("attack", 4.), "attack");
+    auto nWild = toSides(request.getNumber("wild", 6.), "wild");
+    double dMod = double(toBoundedInteger(request.getNumber("mod", 0.), "mod", -nMaxMod, nMaxMod));
+    std::vector<unsigned int> vDamageDice;
+    for (auto dDie: request.getNumbers("damage", {8., 6.}))
+        vDamageDice.push_back(toSides(dDie, "damage"));
+    if (vDamageDice.size()>nMaxDamageDice)
+        throw std::string{"At most "}+std::to_string(nMaxDamageDice)+" damage dice are supported.";
+    auto nRaiseDie = toSides(request.getNumber("raise", 6.), "raise");
+    double dToughness = double(toBoundedInteger(request.getNumber("toughness", 4.), "toughness", 0, nMaxToughness));
+    bool bShaken = request.getBoolean("shaken", false);
+    if (nAttackDie<=1 || nWild==1)
+        throw std::string{"Attack and Wild Die need more than one side."};
+    for (auto nDie: vDamageDice)
+        if (nDie<=1)
+            throw std::string{"Damage dice need more than one side."};
+
+    std::ostringstream sPipelineKey;
+    // Full precision, so nearby modifiers and toughnesses get entries of their own.
+    sPipelineKey << std::setprecision(17) << "attack/"<<nAttackDie<<"/"<<nWild<<"/"<<dMod<<"/";
+    for (auto nDie: vDamageDice)
+        sPipelineKey << nDie << ",";
+    sPipelineKey << "/"<<nRaiseDie;
+    std::shared_ptr<PipelineEntry> pEntry;
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        auto &pSlot = mPipelines[sPipelineKey.str()];
+        if (!pSlot) {
+            pSlot = std::make_shared<PipelineEntry>();
+            pSlot->pPipeline = std::make_unique<AttackPipeline>(nAttackDie, nWild, dMod, vDamageDice, nRaiseDie, dToughness, bShaken, dEpsilon);
+            pSlot->pPipeline->setCache(pDiskCache);
+        }
+        pEntry = pSlot;
+    }
+
+    std::ostringstream sKey;
+    sKey << std::setprecision(17) << sPipelineKey.str() << "/"<<dToughness<<"/"<<(bShaken?1:0);
+    double dHit{.0}, dRaise{.0};
+    auto pTable = getTable(sKey.str(), [&](){
+        std::unique_lock<std::mutex> lock(pEntry->mutex);
+        pEntry->pPipeline->setToughness(dToughness);
+        pEntry->pPipeline->setShaken(bShaken);
+        auto pWounds = pEntry->pPipeline->getWounds();
+        ParallelTabulator tabulator(dEpsilon);
+        if (pDiskCache)
+            return pDiskCache->getTabulated(*pWounds, dEpsilon, [&](){return tabulator.tabulate(pWounds);});
+        return tabulator.tabulate(pWounds);
+    });
+    {
+        std::unique_lock<std::mutex> lock(pEntry->mutex);
+        auto pHitRaises = pEntry->pPipeline->getHitRaises();
+        dHit = 1.-pHitRaises->cdfAt(0);
+        dRaise = 1.-pHitRaises->cdfAt(1);
+    }
+    std::ostringstream s;
+    s << std::setprecision(12) << "\"hit\":"<<dHit<<",\"raise\":"<<dRaise<<","<<formatTable(*pTable);
+    return s.str();
+}
+
+std::string RollServer::answerExpression(const JsonObject& request) {
+    auto sExpression = request.getString("expr", "");
+    std::shared_ptr<ExpressionEntry> pEntry;
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        auto &pSlot = mExpressions[sExpression];
+        if (!pSlot)
+            pSlot = std::make_shared<ExpressionEntry>();
+        pEntry = pSlot;
+    }
+    std::unique_lock<std::mutex> lock(pEntry->mutex);
+    if (!pEntry->pExpression)
+        pEntry->pExpression = std::make_unique<DiceExpression>(sExpression);
+    DiceExpression::Bindings bindings;
+    for (auto &sParameter: pEntry->pExpression->getParameters()) {
+        if (!request.has(sParameter))
+            continue;
+        auto &value = request.get(sParameter);
+        if (value.type==JsonValue::Type::Boolean)
+            bindings[sParameter] = value.bBoolean?1.:0.;
+        else
+            bindings[sParameter] = request.getNumber(sParameter, .0);
+    }
+    auto pRoot = pEntry->pExpression->evaluate(bindings);
+    double dTolerance = request.getNumber("tolerance", 0.);
+    if (!(dTolerance>=0. && dTolerance<1.))
+        throw std::string{"\"tolerance\" must be at least 0 and below 1."};
+    // Planning tabulates leaves to estimate them, so it only happens on a miss or to explain.
+    QueryPlanner planner(dEpsilon, 1., dTolerance);
+    bool bExplain = request.getBoolean("explain", false);
+    std::string sPlan;
+    auto compute = [&](){
+        auto plan = planner.plan(pRoot, true);
+        if (bExplain)
+            sPlan = plan.explain();
+        return std::static_pointer_cast<TabulatedObject>(plan.execute());
+    };
+    std::shared_ptr<TabulatedObject> pTable;
+    if (dTolerance>0.) {
+        // Sampled tables are approximate, keep them apart from the exact ones.
+        std::ostringstream sKey;
+        sKey << std::setprecision(17) << "expr/"<<pRoot->getDescription()<<"/~"<<dTolerance;
+        pTable = getTable(sKey.str(), compute);
+    } else {
+        pTable = getTable("expr/"+pRoot->getDescription(), [&](){
+            if (pDiskCache)
+                return pDiskCache->getTabulated(*pRoot, dEpsilon, compute);
+            return compute();
+        });
+    }
+    if (bExplain) {
+        if (sPlan.empty())
+            sPlan = planner.plan(pRoot, true).explain();
+        return formatTable(*pTable)+",\"plan\":"+JsonObject::quote(sPlan);
+    }
+    return formatTable(*pTable);
+}
+
+std::string RollServer::answerSweep(const JsonObject& request) {
+    std::string sOf = request.getString("of", "trait");
+    if (sOf!="trait" && sOf!="attack" && sOf!="expression")
+        throw std::string{"\"of\" must be \"trait\", \"attack\" or \"expression\"."};
+    std::string sParameter = request.getString("parameter", "mod");
+    double dFrom = request.getNumber("from", 0.);
+    double dTo = request.getNumber("to", dFrom);
+    double dStep = request.getNumber("step", 1.);
+    if (!(dStep>0.) || (dTo-dFrom)/dStep>double(nMaxSweepSize))
+        throw std::string{"Sweep needs a positive step and at most "}+std::to_string(nMaxSweepSize)+" values.";
+
+    std::ostringstream s;
+    s << "\"parameter\":"<<JsonObject::quote(sParameter)<<",\"results\":[";
+    bool bFirst = true;
+    for (double dValue=dFrom; dValue<=dTo+1e-9; dValue+=dStep) {
+        std::ostringstream sSingle;
+        sSingle << "{";
+        for (auto &entry: request.getValues()) {
+            if (entry.first=="type" || entry.first=="of" || entry.first=="parameter" || entry.first=="from" || entry.first=="to" || entry.first=="step" || entry.first=="id")
+                continue;
+            sSingle << JsonObject::quote(entry.first)<<":"<<entry.second.toString()<<",";
+        }
+        sSingle << JsonObject::quote(sParameter)<<":"<<std::setprecision(12)<<dValue<<"}";
+        JsonObject single(sSingle.str());
+        s << (bFirst?"":",") << "{\"value\":"<<std::setprecision(12)<<dValue<<","
+          << answer(single, sOf)<<"}";
+        bFirst = false;
+    }
+    s << "]";
+    return s.str();
+}
+
+std::string RollServer::answerStats(void) {
+    std::vector<double> vSorted;
+    {
+        std::unique_lock<std::mutex> lock(statsMutex);
+        vSorted = vLatencies;
+    }
+    std::sort(vSorted.begin(), vSorted.end());
+    auto percentile = [&vSorted](double dP) {
+        if (vSorted.empty())
+            return .0;
+        auto nIndex = std::size_t(std::ceil(dP*double(vSorted.size())))-1;
+        return vSorted[std::min(nIndex, vSorted.size()-1)];
+    };
+    std::uint64_t nHits = nCacheHits, nMisses = nCacheMisses;
+    std::ostringstream s;
+    s << std::setprecision(6);
+    s << "\"requests\":"<<nRequests<<",\"cacheHits\":"<<nHits<<",\"cacheMisses\":"<<nMisses
+      << ",\"cacheHitRate\":"<<(nHits+nMisses>0?double(nHits)/double(nHits+nMisses):.0)
+      << ",\"cachedTables\":";
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        s << mTables.size();
+    }
+    s << ",\"latencyMs\":{\"p50\":"<<percentile(.5)<<",\"p90\":"<<percentile(.9)<<",\"p99\":"<<percentile(.99)
+      << ",\"max\":"<<(vSorted.empty()?.0:vSorted.back())<<"}";
+    return s.str();
+}
+
+std::string RollServer::answer(const JsonObject& request, const std::string& sType) {
+    if (sType=="trait")
+        return answerTrait(request);
+    if (sType=="attack")
+        return answerAttack(request);
+    if (sType=="expression")
+        return answerExpression(request);
+    if (sType=="sweep")
+        return answerSweep(request);
+    if (sType=="stats")
+        return answerStats();
+    throw std::string{"Unknown request type \""}+sType+"\".";
+}
+
+void RollServer::recordLatency(double dMilliseconds) {
+    std::unique_lock<std::mutex> lock(statsMutex);
+    if (vLatencies.size()<nLatencyWindow) {
+        vLatencies.push_back(dMilliseconds);
+    } else {
+        vLatencies[nLatencyPos] = dMilliseconds;
+        nLatencyPos = (nLatencyPos+1)%nLatencyWindow;
+    }
+}
+
+std::string RollServer::handleRequest(const std::string& sLine, std::chrono::steady_clock::time_point tReceived) {
+    std::string sId{"null"};
+    std::string sBody;
+    std::string sType;
+    try {
+        JsonObject request(sLine);
+        if (request.has("id"))
+            sId = request.get("id").toString();
+        sType = request.getString("type", "");
+        sBody = answer(request, sType);
+    } catch (std::string& sError) {
+        sBody = "\"error\":"+JsonObject::quote(sError);
+    } catch (std::exception& e) {
+        sBody = "\"error\":"+JsonObject::quote(e.what());
+    }
+    if (sType!="stats") {
+        ++nRequests;
+        std::chrono::duration<double, std::milli> tElapsed = std::chrono::steady_clock::now()-tReceived;
+        recordLatency(tElapsed.count());
+    }
+    return "{\"id\":"+sId+","+sBody+"}";
+}
@@ -0,0 +1,136 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __ROLLSERVER_H__
+#define __ROLLSERVER_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "JsonObject.h"
+#include "TabulatedObject.h"
+#include "AttackPipeline.h"
+#include "DistributionCache.h"
+#include "DiceExpression.h"
+
+// Answers newline delimited JSON requests from an in-process cache of tabulated distributions.
+// The cached tables, attack pipelines and parsed expressions are each limited to the most recently used entries.
+// handleRequest may be called from several threads at once.
+//
+// Requests (all fields but "type" are optional):
+//   {"id":1, "type":"trait", "die":8, "wild":6, "mod":0, "rerolls":0}
+//   {"id":2, "type":"attack", "attack":8, "wild":6, "mod":0, "damage":[8,6], "raise":6, "toughness":4, "shaken":false}
+//   {"id":3, "type":"expression", "expr":"max(d8!, d6!) + $mod", "mod":1, "tolerance":0, "explain":false}
+//   {"id":4, "type":"sweep", "of":"trait", "parameter":"mod", "from":-4, "to":4, "step":1, ...fields of "of"}
+//   {"id":5, "type":"stats"}
+// Dice have at most 1000 sides, "mod" lies in [-1000, 1000], "rerolls" in [0, 100] and "toughness" in
+// [0, 1000]; all of them must be integers.
+// Expressions are evaluated as chosen by a QueryPlanner; a nonzero "tolerance" allows sampling and
+// "explain" adds the plan as text.
+class RollServer {
+    private:
+        typedef std::shared_future<std::shared_ptr<TabulatedObject>> TableFuture;
+        struct PipelineEntry {
+            std::mutex mutex;
+            std::unique_ptr<AttackPipeline> pPipeline;
+        };
+        struct ExpressionEntry {
+            std::mutex mutex;
+            std::unique_ptr<DiceExpression> pExpression;
+        };
+        // Map that drops its least recently used entry once it holds more than nCapacity. Not thread safe.
+        template<typename Value>
+        class LruMap {
+            private:
+                std::size_t nCapacity;
+                std::list<std::string> lUsage; // most recently used first
+                std::map<std::string, std::pair<Value, std::list<std::string>::iterator>> mEntries;
+            public:
+                LruMap(std::size_t nCapacity_): nCapacity(nCapacity_) {};
+
+                // nullptr if sKey is not there.
+                Value* find(const std::string& sKey) {
+                    auto it = mEntries.find(sKey);
+                    if (it==mEntries.end())
+                        return nullptr;
+                    lUsage.splice(lUsage.begin(), lUsage, it->second.second);
+                    return &it->second.first;
+                };
+                // Adds a default constructed entry if sKey is not there.
+                Value& operator[](const std::string& sKey) {
+                    if (auto pValue = find(sKey))
+                        return *pValue;
+                    if (mEntries.size()>=nCapacity && !lUsage.empty()) {
+                        mEntries.erase(lUsage.back());
+                        lUsage.pop_back();
+                    }
+                    lUsage.push_front(sKey);
+                    return mEntries.emplace(sKey, std::make_pair(Value{}, lUsage.begin())).first->second.first;
+                };
+                std::size_t size(void) const {return mEntries.size();};
+                void erase(const std::string& sKey) {
+                    auto it = mEntries.find(sKey);
+                    if (it==mEntries.end())
+                        return;
+                    lUsage.erase(it->second.second);
+                    mEntries.erase(it);
+                };
+        };
+
+        double dEpsilon;
+        std::shared_ptr<DistributionCache> pDiskCache;
+        std::mutex cacheMutex;
+        LruMap<TableFuture> mTables;
+        LruMap<std::shared_ptr<PipelineEntry>> mPipelines;
+        LruMap<std::shared_ptr<ExpressionEntry>> mExpressions;
+
+        std::atomic<std::uint64_t> nRequests;
+        std::atomic<std::uint64_t> nCacheHits;
+        std::atomic<std::uint64_t> nCacheMisses;
+        std::mutex statsMutex;
+        std::vector<double> vLatencies;
+        std::size_t nLatencyPos;
+
+        std::shared_ptr<TabulatedObject> getTable(const std::string& sKey, const std::function<std::shared_ptr<TabulatedObject>(void)>& compute);
+        std::string answerTrait(const JsonObject& request);
+        std::string answerAttack(const JsonObject& request);
+        std::string answerExpression(const JsonObject& request);
+        std::string answerSweep(const JsonObject& request);
+        std::string answerStats(void);
+        std::string answer(const JsonObject& request, const std::string& sType);
+        void recordLatency(double dMilliseconds);
+    public:
+        // Tables missing from the in-process cache are looked up in pDiskCache_ (may be nullptr) before computing them.
+        RollServer(const std::shared_ptr<DistributionCache>& pDiskCache_=nullptr, double dEpsilon_=1e-9);
+        ~RollServer(void) = default;
+
+        // Returns a single line JSON response (without newline); errors are reported as {"error":...}.
+        std::string handleRequest(const std::string& sLine, std::chrono::steady_clock::time_point tReceived=std::chrono::steady_clock::now());
+
+        static std::string formatTable(const TabulatedObject& table);
+};
+
+#endif
@@ -0,0 +1,273 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+
+#define SWROLL_BUILDING
+#include "SWRollAPI.h"
+
+#include "AcingDie.h"
+#include "AdderObject.h"
+#include "ConstantObject.h"
+#include "DiceExpression.h"
+#include "FlatMod.h"
+#include "GroupRoll.h"
+#include "MaxConnector.h"
+#include "OpposedRoll.h"
+#include "ParallelTabulator.h"
+#include "RaiseCounter.h"
+#include "SWTraitRoll.h"
+#include "WoundCalculatorObject.h"
+
+struct swroll_node {
+    // Last table swroll_tabulate computed for the node, shared by all references to it.
+    struct Table {
+        std::mutex mutex;
+        double dEpsilon;
+        std::shared_ptr<TabulatedObject> pTable;
+    };
+    std::shared_ptr<StochasticObject> pObject;
+    // Expression plans are rebound in place, so the node owns its plan.
+    std::shared_ptr<DiceExpression> pExpression;
+    std::shared_ptr<Table> pTable;
+};
+
+namespace {
+    thread_local std::string sLastError;
+    // Same limit as TabulatedObject.
+    const std::size_t nMaxTableSize = 1<<20;
+
+    swroll_status fail(swroll_status status, const std::string& sMessage) {
+        sLastError = sMessage;
+        return status;
+    }
+
+    // Runs body and turns exceptions into status codes, since they must not cross the C boundary.
+    template<typename Body>
+    swroll_status guard(Body body) {
+        try {
+            sLastError.clear();
+            return body();
+        } catch (const std::string& sError) {
+            return fail(SWROLL_INVALID_ARGUMENT, sError);
+        } catch (const std::bad_alloc&) {
+            return fail(SWROLL_FAILED, "Out of memory.");
+        } catch (const std::exception& e) {
+            return fail(SWROLL_FAILED, e.what());
+        } catch (...) {
+            return fail(SWROLL_FAILED, "Unknown error.");
+        }
+    }
+
+    template<typename Build>
+    swroll_node* makeNode(Build build) {
+        swroll_node* pNode = nullptr;
+        guard([&](){
+            pNode = new swroll_node{build(), nullptr, std::make_shared<swroll_node::Table>()};
+            return SWROLL_OK;
+        });
+        return pNode;
+    }
+
+    const std::shared_ptr<StochasticObject>& object(const swroll_node* pNode) {
+        if (!pNode)
+            throw std::string{"Node must not be NULL."};
+        return pNode->pObject;
+    }
+
+    unsigned int checkSides(std::uint32_t nSides) {
+        if (nSides<2)
+            throw std::string{"Dice need at least two sides."};
+        return nSides;
+    }
+}
+
+extern "C" {
+
+std::uint32_t swroll_abi_version(void) {
+    return SWROLL_ABI_VERSION;
+}
+
+const char* swroll_last_error(void) {
+    return sLastError.c_str();
+}
+
+swroll_node* swroll_die(std::uint32_t sides) {
+    return makeNode([&](){return std::make_shared<AcingDie>(checkSides(sides));});
+}
+
+swroll_node* swroll_constant(std::int64_t value) {
+    return makeNode([&](){return std::make_shared<ConstantObject>(double(value));});
+}
+
+swroll_node* swroll_modify(const swroll_node* node, std::int64_t modifier) {
+    return makeNode([&](){return std::make_shared<FlatMod>(object(node), double(modifier));});
+}
+
+swroll_node* swroll_add(const swroll_node* left, const swroll_node* right) {
+    return makeNode([&](){return std::make_shared<AdderObject>(object(left), object(right));});
+}
+
+swroll_node* swroll_max(const swroll_node* first, const swroll_node* second) {
+    return makeNode([&](){return std::make_shared<MaxConnector>(object(first), object(second));});
+}
+
+swroll_node* swroll_raises(const swroll_node* node) {
+    return makeNode([&](){return std::make_shared<RaiseCounter>(object(node));});
+}
+
+swroll_node* swroll_wounds(const swroll_node* damage, std::int64_t toughness, int shaken) {
+    return makeNode([&](){return std::make_shared<WoundCalculatorObject>(object(damage), double(toughness), shaken!=0);});
+}
+
+swroll_node* swroll_group(const swroll_node* member, std::uint32_t members) {
+    return makeNode([&](){return std::make_shared<GroupRoll>(object(member), members);});
+}
+
+swroll_node* swroll_margin(const swroll_node* attacker, const swroll_node* defender) {
+    return makeNode([&](){return std::make_shared<OpposedRoll>(object(attacker), object(defender));});
+}
+
+swroll_node* swroll_trait(std::uint32_t trait_sides, std::uint32_t wild_sides, std::int32_t modifier, std::uint32_t rerolls) {
+    return makeNode([&](){return std::make_shared<SWTraitRoll>(checkSides(trait_sides), checkSides(wild_sides), modifier, int(rerolls));});
+}
+
+swroll_node* swroll_expression(const char* expression, const char* const* names, const double* values, size_t count) {
+    swroll_node* pNode = nullptr;
+    guard([&](){
+        if (!expression || (count>0 && (!names || !values)))
+            throw std::string{"Expression, names and values must not be NULL."};
+        DiceExpression::Bindings bindings;
+        for (std::size_t i=0; i<count; ++i) {
+            if (!names[i])
+                throw std::string{"Parameter names must not be NULL."};
+            bindings[names[i]] = values[i];
+        }
+        auto pExpression = std::make_shared<DiceExpression>(std::string{expression});
+        auto pRoot = pExpression->evaluate(bindings);
+        pNode = new swroll_node{pRoot, pExpression, std::make_shared<swroll_node::Table>()};
+        return SWROLL_OK;
+    });
+    return pNode;
+}
+
+swroll_node* swroll_retain(const swroll_node* node) {
+    swroll_node* pNode = nullptr;
+    guard([&](){
+        object(node);
+        pNode = new swroll_node(*node);
+        return SWROLL_OK;
+    });
+    return pNode;
+}
+
+void swroll_release(swroll_node* node) {
+    delete node;
+}
+
+swroll_status swroll_tabulate(const swroll_node* node, double epsilon, swroll_function function,
+                              std::int64_t* minimum, double* buffer, size_t capacity, size_t* count) {
+    return guard([&](){
+        auto& pObject = object(node);
+        if (!minimum || !count || (capacity>0 && !buffer))
+            return fail(SWROLL_INVALID_ARGUMENT, "Result pointers must not be NULL.");
+        if (!(epsilon>=.0))
+            return fail(SWROLL_INVALID_ARGUMENT, "Epsilon must not be negative.");
+        // Tabulate through the engine once per epsilon, so asking for the size first and then for the
+        // values does not compute the table twice.
+        std::shared_ptr<TabulatedObject> pTable;
+        {
+            std::unique_lock<std::mutex> lock(node->pTable->mutex);
+            if (!node->pTable->pTable || node->pTable->dEpsilon!=epsilon) {
+                node->pTable->pTable = ParallelTabulator(epsilon).tabulate(pObject);
+                node->pTable->dEpsilon = epsilon;
+            }
+            pTable = node->pTable->pTable;
+        }
+        std::int64_t nMinimum = pTable->getIntMinimum();
+        std::int64_t nMaximum = pTable->getIntMaximum();
+        if (nMaximum>=nMinimum && std::uint64_t(nMaximum-nMinimum)>=nMaxTableSize)
+            return fail(SWROLL_FAILED, "The distribution spans more than "+std::to_string(nMaxTableSize)+" values, use a larger epsilon.");
+        std::size_t nCount = nMaximum>=nMinimum ? std::size_t(nMaximum-nMinimum)+1 : 0;
+        for (std::size_t i=0; i<nCount && i<capacity; ++i) {
+            std::int64_t n = nMinimum+std::int64_t(i);
+            buffer[i] = function==SWROLL_CDF ? pTable->cdfAt(n) : pTable->pmfAt(n);
+        }
+        *minimum = nMinimum;
+        *count = nCount;
+        if (nCount>capacity)
+            return fail(SWROLL_BUFFER_TOO_SMALL, "Buffer too small, "+std::to_string(nCount)+" values needed.");
+        return SWROLL_OK;
+    });
+}
+
+swroll_status swroll_evaluate(const swroll_node* node, swroll_function function, const std::int64_t* values, double* results, size_t count) {
+    return guard([&](){
+        auto& pObject = object(node);
+        if (count>0 && (!values || !results))
+            return fail(SWROLL_INVALID_ARGUMENT, "Value and result buffers must not be NULL.");
+        for (std::size_t i=0; i<count; ++i)
+            results[i] = function==SWROLL_CDF ? pObject->cdfAt(values[i]) : pObject->pmfAt(values[i]);
+        return SWROLL_OK;
+    });
+}
+
+swroll_status swroll_moments(const swroll_node* node, double* mean, double* variance) {
+    return guard([&](){
+        auto& pObject = object(node);
+        if (mean)
+            *mean = pObject->mean();
+        if (variance)
+            *variance = pObject->variance();
+        return SWROLL_OK;
+    });
+}
+
+swroll_status swroll_quantile(const swroll_node* node, double probability, std::int64_t* value) {
+    return guard([&](){
+        auto& pObject = object(node);
+        if (!value)
+            return fail(SWROLL_INVALID_ARGUMENT, "Result pointer must not be NULL.");
+        *value = pObject->quantile(probability);
+        return SWROLL_OK;
+    });
+}
+
+swroll_status swroll_describe(const swroll_node* node, char* buffer, size_t capacity, size_t* length) {
+    return guard([&](){
+        auto sDescription = object(node)->getDescription();
+        if (length)
+            *length = sDescription.size();
+        if (capacity==0 || !buffer)
+            return capacity==0 ? fail(SWROLL_BUFFER_TOO_SMALL, "Buffer too small.") : fail(SWROLL_INVALID_ARGUMENT, "Buffer must not be NULL.");
+        std::size_t nCopied = std::min(sDescription.size(), capacity-1);
+        std::memcpy(buffer, sDescription.data(), nCopied);
+        buffer[nCopied] = '\0';
+        if (nCopied<sDescription.size())
+            return fail(SWROLL_BUFFER_TOO_SMALL, "Buffer too small.");
+        return SWROLL_OK;
+    });
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __SWROLLAPI_H__
+#define __SWROLLAPI_H__
+
+/* C interface of the SW Roll Calculator engine, built as the shared library swroll.
+ *
+ * Roll graphs are built from swroll_node handles. Every function returning a node hands out a new
+ * reference that has to be given back with swroll_release. Parents keep their children alive, so
+ * a child may be released as soon as it has been used. Nodes are immutable and may be queried from
+ * several threads at once.
+ *
+ * Functions returning swroll_status report failures by a nonzero value, functions returning nodes
+ * by NULL. In both cases swroll_last_error describes the problem for the calling thread.
+ * Results are written into buffers owned by the caller. A node keeps the table swroll_tabulate
+ * computed last, so only the first call for a node and epsilon allocates and computes it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  ifdef SWROLL_BUILDING
+#    define SWROLL_API __declspec(dllexport)
+#  else
+#    define SWROLL_API __declspec(dllimport)
+#  endif
+#else
+#  define SWROLL_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Increased whenever a function changes incompatibly. */
+#define SWROLL_ABI_VERSION 1
+
+typedef struct swroll_node swroll_node;
+
+typedef enum {
+    SWROLL_OK = 0,
+    SWROLL_INVALID_ARGUMENT = 1,
+    SWROLL_BUFFER_TOO_SMALL = 2,
+    SWROLL_FAILED = 3
+} swroll_status;
+
+typedef enum {
+    SWROLL_PMF = 0, /* probability of exactly each value */
+    SWROLL_CDF = 1  /* probability of each value or less */
+} swroll_function;
+
+SWROLL_API uint32_t swroll_abi_version(void);
+/* Message for the last failed call on this thread, or "" if there was none. */
+SWROLL_API const char* swroll_last_error(void);
+
+/* Building roll graphs. */
+SWROLL_API swroll_node* swroll_die(uint32_t sides);                     /* exploding die */
+SWROLL_API swroll_node* swroll_constant(int64_t value);
+SWROLL_API swroll_node* swroll_modify(const swroll_node* node, int64_t modifier);
+SWROLL_API swroll_node* swroll_add(const swroll_node* left, const swroll_node* right);
+SWROLL_API swroll_node* swroll_max(const swroll_node* first, const swroll_node* second);
+SWROLL_API swroll_node* swroll_raises(const swroll_node* node);        /* successes & raises against 4 */
+SWROLL_API swroll_node* swroll_wounds(const swroll_node* damage, int64_t toughness, int shaken);
+SWROLL_API swroll_node* swroll_group(const swroll_node* member, uint32_t members);
+SWROLL_API swroll_node* swroll_margin(const swroll_node* attacker, const swroll_node* defender);
+SWROLL_API swroll_node* swroll_trait(uint32_t trait_sides, uint32_t wild_sides, int32_t modifier, uint32_t rerolls);
+/* Compiles a DiceExpression (see DiceExpression.h) and binds its parameters. */
+SWROLL_API swroll_node* swroll_expression(const char* expression, const char* const* names, const double* values, size_t count);
+/* Another reference to the same node. */
+SWROLL_API swroll_node* swroll_retain(const swroll_node* node);
+SWROLL_API void swroll_release(swroll_node* node);
+
+/* Writes the distribution from its minimum up to the point where less than epsilon probability is
+ * left into buffer and its first value into minimum. *count receives the number of values; if it
+ * exceeds capacity, nothing useful is written and SWROLL_BUFFER_TOO_SMALL is returned, so
+ * capacity 0 with buffer NULL asks for the size needed; the table is kept, so the second call only
+ * copies it. Distributions spanning more than 2^20 values fail with SWROLL_FAILED. */
+SWROLL_API swroll_status swroll_tabulate(const swroll_node* node, double epsilon, swroll_function function,
+                                         int64_t* minimum, double* buffer, size_t capacity, size_t* count);
+/* results[i] = function at values[i], for count values. */
+SWROLL_API swroll_status swroll_evaluate(const swroll_node* node, swroll_function function,
+                                         const int64_t* values, double* results, size_t count);
+SWROLL_API swroll_status swroll_moments(const swroll_node* node, double* mean, double* variance);
+/* Smallest value whose CDF is at least probability. */
+SWROLL_API swroll_status swroll_quantile(const swroll_node* node, double probability, int64_t* value);
+/* Writes at most capacity bytes of a human readable description, including the terminating zero. */
+SWROLL_API swroll_status swroll_describe(const swroll_node* node, char* buffer, size_t capacity, size_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
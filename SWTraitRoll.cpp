@@ -16,47 +16,105 @@ You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <string>
 #include <memory>
 #include <cmath>
+#include <algorithm>
 
 #include "SWTraitRoll.h"
+#include "ImportanceSampler.h"
 #include "AcingDie.h"
-#include "MaxConnector.h"
-#include "FlatMod.h"
-#include "RaiseCounter.h"
 
 SWTraitRoll::SWTraitRoll(unsigned int nTraitDieSides_, unsigned int nWildDieSides_, int nMod_, int nRerolls_): nTraitDieSides(nTraitDieSides_), nWildDieSides(nWildDieSides_), nMod(nMod_), nRerolls(nRerolls_) {
 }
 
-double SWTraitRoll::distributionFunction(double dX) const {
-    if(dX<-1.)
+double SWTraitRoll::cdfAt(std::int64_t n) const {
+    if(n<-1)
         return .0;
-    auto traitDie = std::make_shared<AcingDie>(nTraitDieSides);
-    auto wildDie = std::make_shared<AcingDie>(nWildDieSides);
-    auto rollResult = std::make_shared<MaxConnector>(traitDie, wildDie);
+    AcingDie traitDie(nTraitDieSides);
+    AcingDie wildDie(nWildDieSides);
+    auto rollResult = [&](std::int64_t nRoll) {return traitDie.cdfAt(nRoll)*wildDie.cdfAt(nRoll);};
 
-    double anyCritFailProbability = 1.-std::pow(1.-rollResult->distributionFunction(1.), nRerolls+1.);
-    double individualCritFailProbability = rollResult->distributionFunction(1.);
+    double individualCritFailProbability = rollResult(1);
+    double anyCritFailProbability = 1.-std::pow(1.-individualCritFailProbability, nRerolls+1.);
 
-    if((dX<.0) || ((dX<1.) && (nMod>=2))) // Probability of crit fail
+    if((n<0) || ((n<1) && (nMod>=2))) // Probability of crit fail
         return anyCritFailProbability;
-    /*if(dX<1.)
-        return 1.-std::pow(rollResult->distributionFunction(4.-nMod),nRerolls+1);*/
 
-    double dIntegerPartOfX = std::floor(dX);
-    double rollLimit = 4.*dIntegerPartOfX-nMod+3.;
-    if(rollLimit<2.)
+    if(n>(nUnbounded-3)/4)
+        return 1.;
+    std::int64_t rollLimit = addSaturated(4*n+3, -std::int64_t(nMod));
+    if(rollLimit<2)
         return anyCritFailProbability;
 
-    double individualNotTooLarge = rollResult->distributionFunction(rollLimit)-rollResult->distributionFunction(1.);
+    double individualNotTooLarge = rollResult(rollLimit)-individualCritFailProbability;
 
-    
     double probability = 1.;
     for (unsigned int i=0; i<=nRerolls; ++i) {
-       probability = individualCritFailProbability + individualNotTooLarge*probability + (1.-individualNotTooLarge - individualCritFailProbability)*(1.-std::pow(1.-rollResult->distributionFunction(1.),i));
+       probability = individualCritFailProbability + individualNotTooLarge*probability + (1.-individualNotTooLarge - individualCritFailProbability)*(1.-std::pow(1.-individualCritFailProbability,i));
     }
-
-    //double probability = critFailProbability + std::pow(rollResult->distributionFunction(4.*dIntegerPartOfX-nMod)-rollResult->distributionFunction(1.),nRerolls);
     return probability;
 }
 
+std::int64_t SWTraitRoll::sample(ImportanceSampler& sampler) const {
+    if (nRerolls>0)
+        return StochasticObject::sample(sampler);
+    auto nTrait = AcingDie(nTraitDieSides).sample(sampler);
+    auto nWild = AcingDie(nWildDieSides).sample(sampler);
+    if (nTrait==1 && nWild==1)
+        return -1;
+    auto nTotal = std::max(nTrait, nWild)+nMod;
+    if (nTotal<4)
+        return 0;
+    return (nTotal-4)/4+1;
+}
+
+std::int64_t SWTraitRoll::getIntMinimum(void) const {
+    return -1;
+}
+
+std::int64_t SWTraitRoll::getIntMaximum(void) const {
+    return nUnbounded;
+}
+
+int SWTraitRoll::findMinimumModifier(double dP, std::int64_t nLevel) const {
+    if (!(dP>.0 && dP<=1.))
+        throw std::string{"Probability must be greater than 0 and at most 1."};
+    if (nLevel<1 || nLevel>(1<<20))
+        throw std::string{"The number of successes & raises must be between 1 and 2^20."};
+    SWTraitRoll roll(*this);
+    auto atLeastLevel = [&](int nMod_) {
+        roll.setMod(nMod_);
+        return 1.-roll.cdfAt(nLevel-1);
+    };
+    // From this modifier on only critical failures fall short of nLevel.
+    int nUpper = int(4*nLevel);
+    if (atLeastLevel(nUpper)<dP)
+        throw std::string{"The probability can not be reached because of critical failures."};
+    // Gallop downwards until atLeastLevel(nLower) < dP <= atLeastLevel(nUpper), then bisect.
+    int nStep = 1;
+    int nLower = nUpper-nStep;
+    while (atLeastLevel(nLower)>=dP) {
+        if (nLower<=-(1<<24))
+            return nLower;
+        nUpper = nLower;
+        nStep *= 2;
+        nLower = nUpper-nStep;
+    }
+    while (nUpper-nLower>1) {
+        int nMiddle = nLower+(nUpper-nLower)/2;
+        if (atLeastLevel(nMiddle)>=dP)
+            nUpper = nMiddle;
+        else
+            nLower = nMiddle;
+    }
+    return nUpper;
+}
+
+std::string SWTraitRoll::getDescription(void) const {
+    return "SWTraitRoll("+std::to_string(nTraitDieSides)+","+std::to_string(nWildDieSides)+","+std::to_string(nMod)+","+std::to_string(nRerolls)+")";
+}
+
+std::shared_ptr<StochasticObject> SWTraitRoll::withChildren(const std::vector<std::shared_ptr<StochasticObject>>&) const {
+    return std::make_shared<SWTraitRoll>(*this);
+}
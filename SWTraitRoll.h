@@ -30,12 +30,20 @@ class SWTraitRoll: public StochasticObject {
         SWTraitRoll(unsigned int nTraitDieSides, unsigned int nWildDieSides = 6, int nMod = 0, int nRerolls_ = 0);
         virtual ~SWTraitRoll(void) = default;
 
-        virtual double distributionFunction(double x) const;
-        virtual double getMinimum(void) const {return -1.;};
+        virtual double cdfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
 
         int getMod(void) const {return nMod;};
         void setMod(int nMod_) {nMod=nMod_;};
 
+        // Smallest modifier with P(at least nLevel successes & raises) >= dP, by bisection over the modifier.
+        // Throws if critical failures make dP unreachable.
+        int findMinimumModifier(double dP, std::int64_t nLevel = 1) const;
+
         unsigned int getRerolls(void) const {return nRerolls;};
         void setRerolls(unsigned int nRerolls_) {nRerolls=nRerolls_;};
 };
@@ -0,0 +1,50 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+
+#include "SparseMatrix.h"
+
+SparseMatrix::SparseMatrix(std::size_t nRows_, std::size_t nColumns_, const std::map<std::pair<std::size_t,std::size_t>, double>& mEntries):
+        nRows(nRows_), nColumns(nColumns_), vRowStart(nRows_+1, 0) {
+    vColumnIndex.reserve(mEntries.size());
+    vValues.reserve(mEntries.size());
+    for (auto &entry: mEntries) {
+        if (entry.first.first>=nRows || entry.first.second>=nColumns)
+            throw std::string{"SparseMatrix entry out of range."};
+        if (entry.second == .0)
+            continue;
+        ++vRowStart[entry.first.first+1];
+        vColumnIndex.push_back(entry.first.second);
+        vValues.push_back(entry.second);
+    }
+    for (std::size_t i=0; i<nRows; ++i)
+        vRowStart[i+1] += vRowStart[i];
+}
+
+std::vector<double> SparseMatrix::multiply(const std::vector<double>& vX) const {
+    if (vX.size()!=nColumns)
+        throw std::string{"SparseMatrix dimension mismatch."};
+    std::vector<double> vY(nRows, .0);
+    for (std::size_t i=0; i<nRows; ++i) {
+        double dSum = .0;
+        for (std::size_t j=vRowStart[i]; j<vRowStart[i+1]; ++j)
+            dSum += vValues[j]*vX[vColumnIndex[j]];
+        vY[i] = dSum;
+    }
+    return vY;
+}
@@ -0,0 +1,45 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __SPARSEMATRIX_H__
+#define __SPARSEMATRIX_H__
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Compressed sparse row matrix. Entries are given as a map from (row, column) to value.
+class SparseMatrix {
+    private:
+        std::size_t nRows;
+        std::size_t nColumns;
+        std::vector<std::size_t> vRowStart;
+        std::vector<std::size_t> vColumnIndex;
+        std::vector<double> vValues;
+    public:
+        SparseMatrix(std::size_t nRows_=0, std::size_t nColumns_=0, const std::map<std::pair<std::size_t,std::size_t>, double>& mEntries={});
+        ~SparseMatrix(void) = default;
+
+        std::vector<double> multiply(const std::vector<double>& vX) const;
+
+        std::size_t getRows(void) const {return nRows;};
+        std::size_t getColumns(void) const {return nColumns;};
+        std::size_t getNonZeros(void) const {return vValues.size();};
+};
+
+#endif
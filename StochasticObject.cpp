@@ -0,0 +1,94 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+
+#include "ImportanceSampler.h"
+#include "StochasticObject.h"
+#include "TabulatedObject.h"
+
+std::pair<double,double> StochasticObject::computeMoments(void) const {
+    // Sum in offsets from the minimum, which keeps E[X^2]-E[X]^2 from cancelling badly.
+    auto nMinimum = getIntMinimum();
+    auto nMaximum = getIntMaximum();
+    double dFirst = .0, dSecond = .0;
+    double dLastCDF = .0;
+    for (std::int64_t nOffset=0; nOffset<(1<<20); ++nOffset) {
+        auto n = addSaturated(nMinimum, nOffset);
+        double dCDF = cdfAt(n);
+        double dMass = dCDF-dLastCDF;
+        dFirst += dMass*double(nOffset);
+        dSecond += dMass*double(nOffset)*double(nOffset);
+        dLastCDF = dCDF;
+        if (1.-dCDF<1e-12 || n>=nMaximum)
+            break;
+    }
+    return {double(nMinimum)+dFirst, std::max(.0, dSecond-dFirst*dFirst)};
+}
+
+std::shared_ptr<TabulatedObject> StochasticObject::tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const {
+    std::vector<std::shared_ptr<StochasticObject>> vObjects(vChildren.begin(), vChildren.end());
+    return std::make_shared<TabulatedObject>(*withChildren(vObjects), dEpsilon);
+}
+
+StochasticObject::CostEstimate StochasticObject::estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const {
+    if (vChildren.empty()) {
+        double dSupport = double(TabulatedObject(*this, dEpsilon).getSize()+1);
+        return {dSupport, 1., .0, dSupport};
+    }
+    CostEstimate estimate{.0, 1., .0, .0};
+    for (auto &child: vChildren) {
+        estimate.dSupport = std::max(estimate.dSupport, child.dSupport);
+        estimate.dQueryCost += child.dQueryCost;
+        estimate.dSetupCost += child.dSetupCost;
+    }
+    // Tabulating withChildren looks every value up once in each child table.
+    estimate.dCombineCost = estimate.dSupport*double(1+vChildren.size());
+    return estimate;
+}
+
+std::int64_t StochasticObject::sample(ImportanceSampler& sampler) const {
+    return quantile(sampler.uniform());
+}
+
+std::int64_t StochasticObject::quantile(double dP) const {
+    if (!(dP>=.0 && dP<=1.))
+        throw std::string{"Probability must be between 0 and 1."};
+    auto nMaximum = getIntMaximum();
+    if (dP>=1. && nMaximum==nUnbounded)
+        throw std::string{"An unbounded distribution has no 100% quantile."};
+    auto nLower = getIntMinimum();
+    if (cdfAt(nLower)>=dP)
+        return nLower;
+    // Gallop upwards until the quantile is bracketed by cdfAt(nLower) < dP <= cdfAt(nUpper) ...
+    std::int64_t nStep = 1;
+    auto nUpper = std::min(addSaturated(nLower, nStep), nMaximum);
+    while (nUpper<nMaximum && cdfAt(nUpper)<dP) {
+        nLower = nUpper;
+        nStep = addSaturated(nStep, nStep);
+        nUpper = std::min(addSaturated(nLower, nStep), nMaximum);
+    }
+    // ... then bisect.
+    while (nUpper-nLower>1) {
+        auto nMiddle = nLower+(nUpper-nLower)/2;
+        if (cdfAt(nMiddle)>=dP)
+            nUpper = nMiddle;
+        else
+            nLower = nMiddle;
+    }
+    return nUpper;
+}
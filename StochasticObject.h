@@ -18,13 +18,111 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef __STOCHASTICOBJECT_H__
 #define __STOCHASTICOBJECT_H__
 
+#include <algorithm>
 #include <utility>
+#include <memory>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
+class ImportanceSampler;
+template<typename Scalar> class BasicTabulatedObject;
+typedef BasicTabulatedObject<double> TabulatedObject;
+
+// All objects take integer values only. Subclasses implement the integer interface (cdfAt,
+// getIntMinimum, getIntMaximum and, where cheaper than a difference of cdfAt, pmfAt); the double
+// valued distributionFunction and getMinimum are thin adapters on top of it.
+//
+// cdfAt, pmfAt, getIntMinimum and the other const members must be safe to call from several
+// threads at once. Setters are not, so do not modify an object while it is being evaluated.
 class StochasticObject {
     public:
+        // Rough operation counts used by QueryPlanner to choose how to evaluate a node.
+        struct CostEstimate {
+            double dSupport;     // number of values up to the epsilon tail
+            double dQueryCost;   // one cdfAt, with the children queried directly
+            double dSetupCost;   // one-off work on the first query, e.g. internal tables
+            double dCombineCost; // tabulateOver from the children's tables
+        };
+
+        // getIntMaximum of objects without an upper bound, e.g. exploding dice.
+        static constexpr std::int64_t nUnbounded = std::numeric_limits<std::int64_t>::max();
+
         virtual ~StochasticObject(void) = default;
-        virtual double distributionFunction(double) const = 0;
-        virtual double getMinimum(void) const = 0;
+
+        // P(X <= n) and P(X == n)
+        virtual double cdfAt(std::int64_t n) const = 0;
+        virtual double pmfAt(std::int64_t n) const {
+            if (n==std::numeric_limits<std::int64_t>::min())
+                return cdfAt(n);
+            return cdfAt(n)-cdfAt(n-1);
+        };
+        virtual std::int64_t getIntMinimum(void) const = 0;
+        virtual std::int64_t getIntMaximum(void) const = 0;
+
+        double distributionFunction(double dX) const {
+            if (std::isnan(dX) || dX<-9.2e18)
+                return .0;
+            if (dX>=9.2e18)
+                return 1.;
+            return cdfAt(std::int64_t(std::floor(dX)));
+        };
+        double getMinimum(void) const {return double(getIntMinimum());};
+
+        // Smallest n with P(X <= n) >= dP, found by galloping and bisecting over cdfAt. Objects without
+        // an upper bound need dP < 1.
+        virtual std::int64_t quantile(double dP) const;
+        // Expected value and variance. By default summed over the distribution until less than 1e-12
+        // probability is left; nodes override this where the moments follow from their children.
+        virtual double mean(void) const {return computeMoments().first;};
+        virtual double variance(void) const {return computeMoments().second;};
+        // Draws one value, by inversion of the CDF unless a node knows better. Exploding dice let
+        // the sampler bias their explosions (see ImportanceSampler).
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+
+        // Canonical text form of the object tree. Objects with equal descriptions have equal distributions.
+        virtual std::string getDescription(void) const = 0;
+        // Objects this one is computed from (empty for leaves) and a copy computed from vChildren instead.
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const {return {};};
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const = 0;
+        // Table of this object computed from vChildren, the tabulated getChildren(). By default
+        // withChildren(vChildren) is tabulated; sums, maxima and mixtures combine the tables directly.
+        virtual std::shared_ptr<TabulatedObject> tabulateOver(const std::vector<std::shared_ptr<TabulatedObject>>& vChildren, double dEpsilon) const;
+        // Some subtrees have a closed form that is faster than tabulating the children at all, e.g. sums
+        // of exploding dice (see DiceSumKernel). tabulateDirectly returns nullptr where there is none and
+        // stops after nMaxSize values, as the TabulatedObject constructor does.
+        virtual bool canTabulateDirectly(void) const {return false;};
+        virtual std::shared_ptr<TabulatedObject> tabulateDirectly(double, std::size_t=1<<20) const {return nullptr;};
+        // Cost of this node given the estimates for getChildren(). Leaves are measured by tabulating them,
+        // inner nodes by default cost one step on top of their children; expensive nodes override this.
+        virtual CostEstimate estimateCost(const std::vector<CostEstimate>& vChildren, double dEpsilon) const;
+    protected:
+        // Mean and variance by summation over the tabulated distribution.
+        std::pair<double,double> computeMoments(void) const;
+
+        static std::string describeNumber(double dX) {
+            std::ostringstream s;
+            s << std::setprecision(17) << dX;
+            return s.str();
+        };
+        // Addition that sticks to the int64 limits instead of overflowing, so nUnbounded stays unbounded.
+        static std::int64_t addSaturated(std::int64_t a, std::int64_t b) {
+            if (b>0 && a>std::numeric_limits<std::int64_t>::max()-b)
+                return std::numeric_limits<std::int64_t>::max();
+            if (b<0 && a<std::numeric_limits<std::int64_t>::min()-b)
+                return std::numeric_limits<std::int64_t>::min();
+            return a+b;
+        };
+        // Throws unless dX is an integer, for parameters given as double.
+        static std::int64_t toInteger(double dX, const char* sWhat) {
+            if (!(std::floor(dX)==dX) || std::fabs(dX)>9e15)
+                throw std::string{sWhat}+" must be an integer.";
+            return std::int64_t(dX);
+        };
 };
 
 #endif
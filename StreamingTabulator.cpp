@@ -0,0 +1,159 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "StreamingTabulator.h"
+
+namespace {
+    // Fewer values per table than this make the result meaningless.
+    const std::size_t nMinimumSpan = 16;
+
+    struct StreamingNode {
+        std::shared_ptr<StochasticObject> pObject;
+        bool bDirect;
+        std::vector<std::shared_ptr<StochasticObject>> vChildren;
+    };
+}
+
+StreamingTabulator::StreamingTabulator(double dEpsilon_, std::size_t nMemoryBudget_): dEpsilon(dEpsilon_), nMemoryBudget(nMemoryBudget_),
+        dTruncatedMass(.0), nLiveBytes(0), nPeakBytes(0) {
+}
+
+std::size_t StreamingTabulator::getSpanLimit(std::size_t nOtherBytes) const {
+    if (nOtherBytes>=nMemoryBudget || (nMemoryBudget-nOtherBytes)/nBytesPerValue<nMinimumSpan)
+        throw std::string{"The memory budget of "}+std::to_string(nMemoryBudget)+" bytes is too small.";
+    return (nMemoryBudget-nOtherBytes)/nBytesPerValue;
+}
+
+std::shared_ptr<TabulatedObject> StreamingTabulator::truncate(const std::shared_ptr<TabulatedObject>& pTable, std::size_t nMaxSize) {
+    if (pTable->getSize()<=nMaxSize)
+        return pTable;
+    auto pTruncated = pTable->truncate(nMaxSize);
+    dTruncatedMass += pTable->cdfAt(pTruncated->getIntMinimum()-1)+std::max(.0, pTruncated->getTailMass()-pTable->getTailMass());
+    return pTruncated;
+}
+
+void StreamingTabulator::hold(const TabulatedObject& table) {
+    nLiveBytes += table.getMemoryBytes();
+    nPeakBytes = std::max(nPeakBytes, nLiveBytes);
+}
+
+void StreamingTabulator::release(const TabulatedObject& table) {
+    nLiveBytes -= std::min(nLiveBytes, table.getMemoryBytes());
+}
+
+std::shared_ptr<TabulatedObject> StreamingTabulator::tabulate(const std::shared_ptr<StochasticObject>& pRoot) {
+    dTruncatedMass = .0;
+    nLiveBytes = 0;
+    nPeakBytes = 0;
+
+    // Topological order by an iterative depth-first search, so deep chains do not exhaust the stack.
+    // Subtrees with a closed form are tabulated as a whole. mConsumers counts the parents still to come.
+    std::vector<StreamingNode> vOrder;
+    std::map<const StochasticObject*, std::size_t> mConsumers;
+    std::vector<std::pair<StreamingNode, std::size_t>> vStack;
+    auto push = [&](const std::shared_ptr<StochasticObject>& pObject) {
+        bool bDirect = pObject->canTabulateDirectly();
+        vStack.push_back({{pObject, bDirect, bDirect ? std::vector<std::shared_ptr<StochasticObject>>{} : pObject->getChildren()}, 0});
+    };
+    push(pRoot);
+    mConsumers[pRoot.get()] = 0;
+    while (!vStack.empty()) {
+        auto &top = vStack.back();
+        if (top.second<top.first.vChildren.size()) {
+            auto pChild = top.first.vChildren[top.second++];
+            if (++mConsumers[pChild.get()]==1)
+                push(pChild);
+            continue;
+        }
+        vOrder.push_back(std::move(top.first));
+        vStack.pop_back();
+    }
+
+    std::map<const StochasticObject*, std::shared_ptr<TabulatedObject>> mTables;
+    for (auto &node: vOrder) {
+        std::shared_ptr<TabulatedObject> pTable;
+        if (node.bDirect) {
+            // The kernel's own table is limited as well, not just its result.
+            auto nLimit = getSpanLimit(nLiveBytes);
+            pTable = node.pObject->tabulateDirectly(dEpsilon, nLimit);
+            if (pTable->getSize()>=nLimit)
+                dTruncatedMass += pTable->getTailMass();
+        } else if (node.vChildren.empty()) {
+            auto nLimit = getSpanLimit(nLiveBytes);
+            pTable = std::make_shared<TabulatedObject>(*node.pObject, dEpsilon, nLimit);
+            // Stopped by the limit rather than by dEpsilon.
+            if (pTable->getSize()>=nLimit)
+                dTruncatedMass += pTable->getTailMass();
+        } else {
+            // Cut the longest inputs down to a common size until the node fits next to all other tables;
+            // short inputs like single dice are left alone, as cutting them would lose far more mass.
+            std::vector<std::shared_ptr<TabulatedObject>> vInputs;
+            std::vector<const StochasticObject*> vCounted;
+            std::size_t nInputBytes = 0, nInputSpan = 0;
+            for (auto &pChild: node.vChildren) {
+                vInputs.push_back(mTables.at(pChild.get()));
+                nInputSpan += vInputs.back()->getSize();
+                if (std::find(vCounted.begin(), vCounted.end(), pChild.get())==vCounted.end()) {
+                    vCounted.push_back(pChild.get());
+                    nInputBytes += vInputs.back()->getMemoryBytes();
+                }
+            }
+            auto nLimit = getSpanLimit(nLiveBytes-std::min(nLiveBytes, nInputBytes));
+            if (nInputSpan>nLimit) {
+                std::vector<std::size_t> vSizes;
+                for (auto &pInput: vInputs)
+                    vSizes.push_back(pInput->getSize());
+                std::sort(vSizes.begin(), vSizes.end());
+                std::size_t nCap = 1, nBelow = 0;
+                for (std::size_t i=0; i<vSizes.size(); ++i) {
+                    // All inputs from i on get nCap values each.
+                    nCap = std::max<std::size_t>(1, (nLimit-std::min(nLimit, nBelow))/(vSizes.size()-i));
+                    if (nCap<=vSizes[i])
+                        break;
+                    nBelow += vSizes[i];
+                }
+                for (std::size_t i=0; i<vInputs.size(); ++i) {
+                    auto pTruncated = truncate(vInputs[i], nCap);
+                    if (pTruncated!=vInputs[i]) {
+                        // Later consumers of the child get the smaller table as well.
+                        auto &pHeld = mTables[node.vChildren[i].get()];
+                        if (pHeld==vInputs[i]) {
+                            release(*pHeld);
+                            pHeld = pTruncated;
+                            hold(*pHeld);
+                        }
+                        vInputs[i] = pTruncated;
+                    }
+                }
+            }
+            pTable = node.pObject->tabulateOver(vInputs, dEpsilon);
+        }
+        hold(*pTable);
+        mTables[node.pObject.get()] = pTable;
+        for (auto &pChild: node.vChildren) {
+            if (--mConsumers[pChild.get()]==0) {
+                release(*mTables[pChild.get()]);
+                mTables.erase(pChild.get());
+            }
+        }
+    }
+    return mTables.at(pRoot.get());
+}
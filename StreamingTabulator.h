@@ -0,0 +1,68 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __STREAMINGTABULATOR_H__
+#define __STREAMINGTABULATOR_H__
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "StochasticObject.h"
+#include "TabulatedObject.h"
+
+// Tabulates an object tree in a fixed memory budget. Nodes are tabulated one at a time in
+// topological order (children first, see StochasticObject::tabulateOver), and a table is released
+// as soon as the last node using it is done, so a chain of sums holds only a few tables at once.
+//
+// Before a node is combined, the spans of its input tables are limited so that inputs, result and
+// work buffers fit into what is left of the budget. Each table keeps the window of values with the
+// most mass (see TabulatedObject::truncate); mass outside moves onto the window's first value or
+// into the tail, and getTruncatedMass adds it up: the result's distribution function is off by at
+// most that much. With a large enough budget nothing is cut
+// and the result is the same as with ParallelTabulator.
+class StreamingTabulator {
+    private:
+        double dEpsilon;
+        std::size_t nMemoryBudget;
+        double dTruncatedMass;
+        std::size_t nLiveBytes;
+        std::size_t nPeakBytes;
+
+        // Span a node may combine, given the bytes already held by other tables.
+        std::size_t getSpanLimit(std::size_t nOtherBytes) const;
+        std::shared_ptr<TabulatedObject> truncate(const std::shared_ptr<TabulatedObject>& pTable, std::size_t nMaxSize);
+        void hold(const TabulatedObject& table);
+        void release(const TabulatedObject& table);
+    public:
+        // Rough bytes per value of span while a node is combined: its inputs, the result and the
+        // work buffers of TabulatedObject::add.
+        static const std::size_t nBytesPerValue = 48;
+
+        StreamingTabulator(double dEpsilon_=1e-9, std::size_t nMemoryBudget_=std::size_t(64)<<20);
+        ~StreamingTabulator(void) = default;
+
+        // Throws a string if the budget cannot even hold a few values per table.
+        std::shared_ptr<TabulatedObject> tabulate(const std::shared_ptr<StochasticObject>& pRoot);
+
+        // Of the last tabulate call: probability moved into tails to stay in budget, and the most
+        // bytes held by tables at any time.
+        double getTruncatedMass(void) const {return dTruncatedMass;};
+        std::size_t getPeakBytes(void) const {return nPeakBytes;};
+};
+
+#endif
@@ -0,0 +1,40 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+
+#include "SWTraitRoll.h"
+#include "SuccessGrid.h"
+
+SuccessGrid::SuccessGrid(const std::vector<unsigned int>& vTraitDice_, int nModFrom_, int nModTo_,
+                         unsigned int nWildDieSides_, unsigned int nRerolls_, std::int64_t nLevel_):
+        vTraitDice(vTraitDice_), nModFrom(nModFrom_), nModTo(nModTo_), nWildDieSides(nWildDieSides_),
+        nRerolls(nRerolls_), nLevel(nLevel_) {
+    if (vTraitDice.empty() || nModTo<nModFrom)
+        throw std::string{"SuccessGrid needs at least one trait die and modifier."};
+    if (getColumns()>(std::size_t(1)<<24)/getRows())
+        throw std::string{"SuccessGrid is limited to 2^24 cells."};
+    vProbability.resize(getRows()*getColumns());
+    // One trait roll per row, only the modifier changes along it.
+    for (std::size_t r=0; r<getRows(); ++r) {
+        SWTraitRoll roll(vTraitDice[r], nWildDieSides, nModFrom, nRerolls);
+        for (std::size_t c=0; c<getColumns(); ++c) {
+            roll.setMod(getMod(c));
+            vProbability[r*getColumns()+c] = 1.-roll.cdfAt(nLevel-1);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __SUCCESSGRID_H__
+#define __SUCCESSGRID_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Probability of at least nLevel successes & raises for every combination of trait die (rows) and
+// modifier (columns), stored densely in row-major order for heatmaps and batch output.
+class SuccessGrid {
+    private:
+        std::vector<unsigned int> vTraitDice;
+        int nModFrom;
+        int nModTo;
+        unsigned int nWildDieSides;
+        unsigned int nRerolls;
+        std::int64_t nLevel;
+        std::vector<double> vProbability;
+    public:
+        SuccessGrid(const std::vector<unsigned int>& vTraitDice_, int nModFrom_, int nModTo_,
+                    unsigned int nWildDieSides_=6, unsigned int nRerolls_=0, std::int64_t nLevel_=1);
+        ~SuccessGrid(void) = default;
+
+        std::size_t getRows(void) const {return vTraitDice.size();};
+        std::size_t getColumns(void) const {return std::size_t(nModTo-nModFrom+1);};
+        double at(std::size_t nRow, std::size_t nColumn) const {return vProbability[nRow*getColumns()+nColumn];};
+        const std::vector<double>& getData(void) const {return vProbability;};
+
+        unsigned int getTraitDie(std::size_t nRow) const {return vTraitDice[nRow];};
+        int getMod(std::size_t nColumn) const {return nModFrom+int(nColumn);};
+        unsigned int getWildDieSides(void) const {return nWildDieSides;};
+        unsigned int getRerolls(void) const {return nRerolls;};
+        std::int64_t getLevel(void) const {return nLevel;};
+};
+
+#endif
@@ -0,0 +1,430 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AttackPipeline.h"
+#include "JsonObject.h"
+#include "SWTraitRoll.h"
+#include "SweepJob.h"
+#include "ThreadPool.h"
+
+namespace {
+    const std::size_t nMaxListSize = 10000;
+    const std::size_t nMaxPoints = 1000000000;
+
+    long parseInteger(const std::string& sText, const std::string& sKey) {
+        char* pEnd = nullptr;
+        errno = 0;
+        long nValue = std::strtol(sText.c_str(), &pEnd, 10);
+        if (sText.empty() || *pEnd!='\0' || errno!=0)
+            throw std::string{"\""}+sText+"\" is not an integer (in "+sKey+").";
+        return nValue;
+    }
+
+    // "4,6,8" or "-4:4" or a mix like "0,2:4".
+    std::vector<long> parseList(const std::string& sText, const std::string& sKey) {
+        std::vector<long> vValues;
+        std::istringstream items(sText);
+        std::string sItem;
+        while (std::getline(items, sItem, ',')) {
+            auto nColon = sItem.find(':', 1);
+            long nFrom = parseInteger(sItem.substr(0, nColon), sKey);
+            long nTo = nColon==std::string::npos ? nFrom : parseInteger(sItem.substr(nColon+1), sKey);
+            if (nTo<nFrom || std::size_t(nTo-nFrom)>=nMaxListSize)
+                throw std::string{"Bad range \""}+sItem+"\" in "+sKey+".";
+            for (long n=nFrom; n<=nTo; ++n)
+                vValues.push_back(n);
+            if (vValues.size()>nMaxListSize)
+                throw std::string{"Too many values in "}+sKey+".";
+        }
+        if (vValues.empty())
+            throw std::string{"No values given for "}+sKey+".";
+        return vValues;
+    }
+
+    template<typename T>
+    std::vector<T> parseListAs(const std::string& sText, const std::string& sKey, long nMinimum) {
+        std::vector<T> vValues;
+        for (auto n: parseList(sText, sKey)) {
+            if (n<nMinimum)
+                throw std::string{"Values of "}+sKey+" must be at least "+std::to_string(nMinimum)+".";
+            vValues.push_back(T(n));
+        }
+        return vValues;
+    }
+
+    template<typename T>
+    std::string joinList(const std::vector<T>& vValues, char cSeparator=',') {
+        std::ostringstream s;
+        for (std::size_t i=0; i<vValues.size(); ++i)
+            s << (i>0?std::string(1, cSeparator):"") << vValues[i];
+        return s.str();
+    }
+
+    bool fileExists(const std::string& sPath) {
+        struct stat info;
+        return stat(sPath.c_str(), &info)==0;
+    }
+
+    // Flushes sTempPath to disk and moves it to sPath in one step.
+    void commitFile(const std::string& sTempPath, const std::string& sPath) {
+        int nFile = open(sTempPath.c_str(), O_RDONLY);
+        if (nFile>=0) {
+            fsync(nFile);
+            close(nFile);
+        }
+        if (rename(sTempPath.c_str(), sPath.c_str())!=0) {
+            unlink(sTempPath.c_str());
+            throw std::string{"Could not write "}+sPath+".";
+        }
+    }
+
+    std::string getTempPath(const std::string& sPath) {
+        std::ostringstream s;
+        s << sPath<<".tmp."<<getpid()<<"."<<std::hash<std::thread::id>()(std::this_thread::get_id());
+        return s.str();
+    }
+}
+
+SweepJob::Definition::Definition(void): sOf("trait"), vDice({4, 6, 8, 10, 12}), vWildDice({6}), vMods({0}), vRerolls({0}),
+        vDamageProfiles({{8, 6}}), nRaiseDie(6), vToughness({4}), vShaken({0}), nChunkSize(64) {
+}
+
+std::string SweepJob::Definition::toString(void) const {
+    std::vector<std::string> vProfiles;
+    for (auto &vProfile: vDamageProfiles)
+        vProfiles.push_back(joinList(vProfile, '+'));
+    std::ostringstream s;
+    s << "of="<<sOf<<";dice="<<joinList(vDice)<<";wild="<<joinList(vWildDice)<<";mods="<<joinList(vMods);
+    if (sOf=="trait")
+        s << ";rerolls="<<joinList(vRerolls);
+    else
+        s << ";damage="<<joinList(vProfiles, '|')<<";raise="<<nRaiseDie<<";toughness="<<joinList(vToughness)<<";shaken="<<joinList(vShaken);
+    s << ";chunk="<<nChunkSize;
+    return s.str();
+}
+
+SweepJob::Definition SweepJob::Definition::fromString(const std::string& sText) {
+    Definition definition;
+    std::istringstream fields(sText);
+    std::string sField;
+    while (std::getline(fields, sField, ';')) {
+        if (sField.empty())
+            continue;
+        auto nEquals = sField.find('=');
+        if (nEquals==std::string::npos)
+            throw std::string{"Expected key=value instead of \""}+sField+"\".";
+        auto sKey = sField.substr(0, nEquals);
+        auto sValue = sField.substr(nEquals+1);
+        if (sKey=="of") {
+            definition.sOf = sValue;
+        } else if (sKey=="dice") {
+            definition.vDice = parseListAs<unsigned int>(sValue, sKey, 2);
+        } else if (sKey=="wild") {
+            definition.vWildDice = parseListAs<unsigned int>(sValue, sKey, 0);
+        } else if (sKey=="mods") {
+            definition.vMods = parseListAs<int>(sValue, sKey, -1000);
+        } else if (sKey=="rerolls") {
+            definition.vRerolls = parseListAs<unsigned int>(sValue, sKey, 0);
+        } else if (sKey=="damage") {
+            definition.vDamageProfiles.clear();
+            std::istringstream profiles(sValue);
+            std::string sProfile;
+            while (std::getline(profiles, sProfile, '|')) {
+                std::replace(sProfile.begin(), sProfile.end(), '+', ',');
+                definition.vDamageProfiles.push_back(parseListAs<unsigned int>(sProfile, sKey, 2));
+            }
+        } else if (sKey=="raise") {
+            definition.nRaiseDie = (unsigned int)parseListAs<unsigned int>(sValue, sKey, 0).front();
+        } else if (sKey=="toughness") {
+            definition.vToughness = parseListAs<int>(sValue, sKey, -1000);
+        } else if (sKey=="shaken") {
+            definition.vShaken = parseListAs<unsigned int>(sValue, sKey, 0);
+        } else if (sKey=="chunk") {
+            definition.nChunkSize = parseListAs<std::size_t>(sValue, sKey, 1).front();
+        } else {
+            throw std::string{"Unknown sweep parameter \""}+sKey+"\".";
+        }
+    }
+    definition.validate();
+    return definition;
+}
+
+void SweepJob::Definition::validate(void) const {
+    if (sOf!="trait" && sOf!="attack")
+        throw std::string{"A sweep is either of \"trait\" or of \"attack\"."};
+    for (auto nWild: vWildDice)
+        if (nWild==1 || (nWild==0 && sOf=="trait"))
+            throw std::string{sOf=="trait" ? "Wild Dice need more than one side." : "Wild Dice need more than one side, or 0 for none."};
+    for (auto nRerolls: vRerolls)
+        if (nRerolls>100)
+            throw std::string{"At most 100 rerolls."};
+    if (sOf=="attack" && vDamageProfiles.empty())
+        throw std::string{"No damage profile given."};
+    if (nRaiseDie==1)
+        throw std::string{"The raise die needs more than one side, or 0 for none."};
+    for (auto nShaken: vShaken)
+        if (nShaken>1)
+            throw std::string{"shaken takes 0 and 1."};
+    if (nChunkSize<1)
+        throw std::string{"Chunks need at least one point."};
+    if (getPointCount()>nMaxPoints)
+        throw std::string{"The sweep has more than "}+std::to_string(nMaxPoints)+" points.";
+}
+
+std::size_t SweepJob::Definition::getPointCount(void) const {
+    double dCount = double(vDice.size())*double(vWildDice.size())*double(vMods.size());
+    if (sOf=="trait")
+        dCount *= double(vRerolls.size());
+    else
+        dCount *= double(vDamageProfiles.size())*double(vToughness.size())*double(vShaken.size());
+    return dCount>double(nMaxPoints) ? nMaxPoints+1 : std::size_t(dCount);
+}
+
+SweepJob::SweepJob(const std::string& sDirectory_, const Definition& definition_, double dEpsilon_): sDirectory(sDirectory_),
+        definition(definition_), dEpsilon(dEpsilon_), sDone({}), bMerged(false) {
+    definition.validate();
+    if (mkdir(sDirectory.c_str(), 0755)!=0 && errno!=EEXIST)
+        throw std::string{"Could not create "}+sDirectory+".";
+    // Temporary files of an interrupted run are incomplete by definition.
+    if (DIR* pDirectory = opendir(sDirectory.c_str())) {
+        while (dirent* pEntry = readdir(pDirectory))
+            if (std::string{pEntry->d_name}.find(".tmp.")!=std::string::npos)
+                unlink((sDirectory+"/"+pEntry->d_name).c_str());
+        closedir(pDirectory);
+    }
+    if (fileExists(getManifestPath())) {
+        std::ifstream file(getManifestPath());
+        std::stringstream sContent;
+        sContent << file.rdbuf();
+        JsonObject manifest(sContent.str());
+        if (manifest.getString("definition", "")!=definition.toString())
+            throw std::string{sDirectory+" holds a different sweep: "}+manifest.getString("definition", "");
+        bMerged = manifest.getBoolean("merged", false);
+        // Finished chunks are stored as [from, to) ranges.
+        auto vRanges = manifest.getNumbers("done", {});
+        for (std::size_t i=0; i+1<vRanges.size(); i+=2)
+            for (auto nChunk=std::size_t(vRanges[i]); nChunk<std::size_t(vRanges[i+1]); ++nChunk)
+                sDone.insert(nChunk);
+    }
+    if (!bMerged) {
+        // A chunk renamed into place just before a crash is complete even if the manifest missed it.
+        for (std::size_t nChunk=0; nChunk<getChunkCount(); ++nChunk) {
+            if (fileExists(getChunkPath(nChunk)))
+                sDone.insert(nChunk);
+            else
+                sDone.erase(nChunk);
+        }
+    }
+    writeManifest();
+}
+
+SweepJob::Definition SweepJob::readDefinition(const std::string& sDirectory) {
+    std::ifstream file(sDirectory+"/manifest.json");
+    if (!file)
+        throw std::string{"No sweep found in "}+sDirectory+".";
+    std::stringstream sContent;
+    sContent << file.rdbuf();
+    return Definition::fromString(JsonObject(sContent.str()).getString("definition", ""));
+}
+
+std::size_t SweepJob::getChunkCount(void) const {
+    return (definition.getPointCount()+definition.nChunkSize-1)/definition.nChunkSize;
+}
+
+std::string SweepJob::getChunkPath(std::size_t nChunk) const {
+    std::ostringstream s;
+    s << sDirectory<<"/chunk-"<<std::setw(6)<<std::setfill('0')<<nChunk<<".csv";
+    return s.str();
+}
+
+std::string SweepJob::getManifestPath(void) const {
+    return sDirectory+"/manifest.json";
+}
+
+std::string SweepJob::getResultPath(void) const {
+    return sDirectory+"/results.csv";
+}
+
+std::string SweepJob::getHeader(const std::string& sOf) {
+    if (sOf=="trait")
+        return "die,wild,mod,rerolls,crit_fail,fail,success,raise_1,raise_2,raise_3,raise_4_or_more,mean";
+    return "die,wild,mod,damage,raise_die,toughness,shaken,hit,raise,wounds_0,wounds_1,wounds_2,wounds_3,wounds_4,wounds_5_or_more,mean_wounds";
+}
+
+void SweepJob::writeAtomically(const std::string& sPath, const std::string& sContent) {
+    auto sTempPath = getTempPath(sPath);
+    {
+        std::ofstream file(sTempPath, std::ios::binary|std::ios::trunc);
+        file << sContent;
+        if (!file) {
+            file.close();
+            unlink(sTempPath.c_str());
+            throw std::string{"Could not write "}+sPath+".";
+        }
+    }
+    commitFile(sTempPath, sPath);
+}
+
+void SweepJob::writeManifest(void) {
+    std::vector<std::string> vRanges;
+    for (auto it=sDone.begin(); it!=sDone.end();) {
+        auto nFrom = *it, nTo = *it+1;
+        for (++it; it!=sDone.end() && *it==nTo; ++it)
+            ++nTo;
+        vRanges.push_back(std::to_string(nFrom)+","+std::to_string(nTo));
+    }
+    std::ostringstream s;
+    s << "{\"version\":1,\"definition\":"<<JsonObject::quote(definition.toString())<<",\"points\":"<<definition.getPointCount()
+      << ",\"chunks\":"<<getChunkCount()<<",\"done\":["<<joinList(vRanges)<<"],\"merged\":"<<(bMerged?"true":"false")<<"}\n";
+    writeAtomically(getManifestPath(), s.str());
+}
+
+std::string SweepJob::computeChunk(std::size_t nChunk) const {
+    std::ostringstream s;
+    s << std::setprecision(10);
+    auto nFirst = nChunk*definition.nChunkSize;
+    auto nEnd = std::min(nFirst+definition.nChunkSize, definition.getPointCount());
+    std::unique_ptr<AttackPipeline> pPipeline;
+    std::string sPipelineKey;
+    for (auto nPoint=nFirst; nPoint<nEnd; ++nPoint) {
+        // Mixed radix decoding, last parameter fastest.
+        auto nRest = nPoint;
+        auto take = [&nRest](std::size_t nSize){auto nIndex = nRest%nSize; nRest /= nSize; return nIndex;};
+        if (definition.sOf=="trait") {
+            auto nRerolls = definition.vRerolls[take(definition.vRerolls.size())];
+            auto nMod = definition.vMods[take(definition.vMods.size())];
+            auto nWild = definition.vWildDice[take(definition.vWildDice.size())];
+            auto nDie = definition.vDice[take(definition.vDice.size())];
+            SWTraitRoll traitRoll(nDie, nWild, nMod, int(nRerolls));
+            s << nDie<<","<<nWild<<","<<nMod<<","<<nRerolls<<","<<traitRoll.cdfAt(-1);
+            for (std::int64_t n=0; n<=4; ++n)
+                s << ","<<traitRoll.pmfAt(n);
+            s << ","<<1.-traitRoll.cdfAt(4)<<","<<traitRoll.mean()<<"\n";
+        } else {
+            auto nShaken = definition.vShaken[take(definition.vShaken.size())];
+            auto nToughness = definition.vToughness[take(definition.vToughness.size())];
+            auto &vDamage = definition.vDamageProfiles[take(definition.vDamageProfiles.size())];
+            auto nMod = definition.vMods[take(definition.vMods.size())];
+            auto nWild = definition.vWildDice[take(definition.vWildDice.size())];
+            auto nDie = definition.vDice[take(definition.vDice.size())];
+            // Points of a chunk mostly differ in toughness and shaken only, which the pipeline answers from its tables.
+            auto sKey = std::to_string(nDie)+"/"+std::to_string(nWild)+"/"+std::to_string(nMod)+"/"+joinList(vDamage, '+');
+            if (!pPipeline || sKey!=sPipelineKey) {
+                pPipeline = std::make_unique<AttackPipeline>(nDie, nWild, double(nMod), vDamage, definition.nRaiseDie, double(nToughness), nShaken!=0, dEpsilon);
+                sPipelineKey = sKey;
+            }
+            pPipeline->setToughness(double(nToughness));
+            pPipeline->setShaken(nShaken!=0);
+            auto pHitRaises = pPipeline->getHitRaises();
+            auto pWounds = pPipeline->getWounds();
+            s << nDie<<","<<nWild<<","<<nMod<<","<<joinList(vDamage, '+')<<","<<definition.nRaiseDie<<","<<nToughness<<","<<nShaken
+              << ","<<1.-pHitRaises->cdfAt(0)<<","<<1.-pHitRaises->cdfAt(1);
+            for (std::int64_t n=0; n<=4; ++n)
+                s << ","<<pWounds->pmfAt(n);
+            s << ","<<1.-pWounds->cdfAt(4)<<","<<pWounds->mean()<<"\n";
+        }
+    }
+    return s.str();
+}
+
+std::size_t SweepJob::run(std::size_t nThreads, const std::function<void(std::size_t, std::size_t)>& progress) {
+    if (bMerged)
+        return 0;
+    std::vector<std::size_t> vMissing;
+    for (std::size_t nChunk=0; nChunk<getChunkCount(); ++nChunk)
+        if (!sDone.count(nChunk))
+            vMissing.push_back(nChunk);
+    std::string sError;
+    {
+        ThreadPool pool(std::min(nThreads>0 ? nThreads : std::size_t(std::max(1u, std::thread::hardware_concurrency())), std::max<std::size_t>(vMissing.size(), 1)));
+        for (auto nChunk: vMissing) {
+            pool.submit([this, nChunk, &sError, &progress](){
+                {
+                    std::unique_lock<std::mutex> lock(manifestMutex);
+                    if (!sError.empty())
+                        return;
+                }
+                try {
+                    writeAtomically(getChunkPath(nChunk), computeChunk(nChunk));
+                    std::unique_lock<std::mutex> lock(manifestMutex);
+                    sDone.insert(nChunk);
+                    writeManifest();
+                    if (progress)
+                        progress(sDone.size(), getChunkCount());
+                } catch (const std::string& sChunkError) {
+                    std::unique_lock<std::mutex> lock(manifestMutex);
+                    if (sError.empty())
+                        sError = sChunkError;
+                }
+            });
+        }
+        pool.wait();
+    }
+    if (!sError.empty())
+        throw sError;
+    merge();
+    return vMissing.size();
+}
+
+void SweepJob::merge(void) {
+    if (bMerged)
+        return;
+    if (sDone.size()<getChunkCount())
+        throw std::string{"Cannot merge, "}+std::to_string(getChunkCount()-sDone.size())+" chunks are missing.";
+    auto sTempPath = getTempPath(getResultPath());
+    {
+        std::ofstream output(sTempPath, std::ios::binary|std::ios::trunc);
+        output << getHeader(definition.sOf) << "\n";
+        // Stream chunk by chunk, so only one buffer is held in memory.
+        for (std::size_t nChunk=0; nChunk<getChunkCount(); ++nChunk) {
+            std::ifstream input(getChunkPath(nChunk), std::ios::binary);
+            if (!input)
+                throw std::string{"Cannot read "}+getChunkPath(nChunk)+".";
+            if (input.peek()!=std::ifstream::traits_type::eof())
+                output << input.rdbuf();
+        }
+        if (!output) {
+            output.close();
+            unlink(sTempPath.c_str());
+            throw std::string{"Could not write "}+getResultPath()+".";
+        }
+    }
+    commitFile(sTempPath, getResultPath());
+    bMerged = true;
+    writeManifest();
+    // Only now that the manifest says so are the chunks no longer needed.
+    for (std::size_t nChunk=0; nChunk<getChunkCount(); ++nChunk)
+        unlink(getChunkPath(nChunk).c_str());
+}
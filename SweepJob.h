@@ -0,0 +1,98 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __SWEEPJOB_H__
+#define __SWEEPJOB_H__
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Long parameter sweep over trait rolls or attacks, written as CSV into a directory so it survives
+// interruptions. The grid points are split into chunks of nChunkSize consecutive points. Every
+// finished chunk is written to its own file, then recorded in manifest.json; both are written to a
+// temporary file and renamed, so a crash never leaves partial files behind. Running the same sweep
+// again skips the chunks in the manifest. At the end the chunk files are streamed into results.csv
+// in grid order and removed.
+//
+// Grid order, last parameter fastest:
+//   trait:  dice, wild, mods, rerolls
+//   attack: dice, wild, mods, damage, toughness, shaken
+class SweepJob {
+    public:
+        struct Definition {
+            std::string sOf; // "trait" or "attack"
+            std::vector<unsigned int> vDice;
+            std::vector<unsigned int> vWildDice;
+            std::vector<int> vMods;
+            std::vector<unsigned int> vRerolls;
+            std::vector<std::vector<unsigned int>> vDamageProfiles;
+            unsigned int nRaiseDie;
+            std::vector<int> vToughness;
+            std::vector<unsigned int> vShaken;
+            std::size_t nChunkSize;
+
+            Definition(void);
+            // Canonical "key=value;..." form stored in the manifest. Lists are comma separated, damage
+            // profiles separated by '|' with '+' between the dice. fromString throws a string on bad input.
+            std::string toString(void) const;
+            static Definition fromString(const std::string& sText);
+            // Throws a string unless the sweep is well formed.
+            void validate(void) const;
+            std::size_t getPointCount(void) const;
+        };
+    private:
+        std::string sDirectory;
+        Definition definition;
+        double dEpsilon;
+        std::set<std::size_t> sDone;
+        bool bMerged;
+        std::mutex manifestMutex;
+
+        std::string getChunkPath(std::size_t nChunk) const;
+        std::string getManifestPath(void) const;
+        std::string computeChunk(std::size_t nChunk) const;
+        void writeManifest(void);
+        static void writeAtomically(const std::string& sPath, const std::string& sContent);
+    public:
+        // Opens the sweep in sDirectory_, creating the directory and the manifest if needed. An existing
+        // manifest must describe the same sweep.
+        SweepJob(const std::string& sDirectory_, const Definition& definition_, double dEpsilon_=1e-9);
+        ~SweepJob(void) = default;
+        SweepJob(const SweepJob&) = delete;
+        SweepJob& operator=(const SweepJob&) = delete;
+
+        // Definition stored in the manifest of sDirectory, to resume a sweep without repeating it.
+        static Definition readDefinition(const std::string& sDirectory);
+
+        // Computes the missing chunks on nThreads threads (0: all hardware threads), calling
+        // progress(finished, total) after each one, then merges. Returns the number of chunks computed.
+        std::size_t run(std::size_t nThreads=0, const std::function<void(std::size_t, std::size_t)>& progress=nullptr);
+        // Streams the chunk files into results.csv. Throws a string if a chunk is missing.
+        void merge(void);
+
+        std::size_t getChunkCount(void) const;
+        std::size_t getFinishedChunkCount(void) const {return sDone.size();};
+        bool isMerged(void) const {return bMerged;};
+        std::string getResultPath(void) const;
+        static std::string getHeader(const std::string& sOf);
+};
+
+#endif
@@ -0,0 +1,428 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "Hashing.h"
+#include "TabulatedObject.h"
+
+namespace {
+    // Neumaier's variant of Kahan summation: the error stays about one rounding, however many terms.
+    template<typename Scalar>
+    struct CompensatedSum {
+        Scalar dSum = 0, dCompensation = 0;
+        void add(Scalar dTerm) {
+            Scalar dNew = dSum+dTerm;
+            if (std::fabs(dSum)>=std::fabs(dTerm))
+                dCompensation += (dSum-dNew)+dTerm;
+            else
+                dCompensation += (dTerm-dNew)+dSum;
+            dSum = dNew;
+        }
+        Scalar get(void) const {return dSum+dCompensation;}
+    };
+
+    // Error of a compensated sum of nTerms terms with total at most 1.
+    double getSummationError(double dUnit, std::size_t nTerms) {
+        return 2.*dUnit+2.*double(nTerms)*dUnit*dUnit;
+    }
+
+    // Type used for the moments, at least double.
+    template<typename Scalar>
+    using Wide = decltype(Scalar{}+double{});
+}
+
+template<typename Scalar>
+BasicTabulatedObject<Scalar>::BasicTabulatedObject(void): nMinimum(0), vDistribution({}), vRunStart({}), vRunOffset({}), dLastCDF(0),
+        nLastValue(-1), dErrorBound(.0) {
+}
+
+template<typename Scalar>
+BasicTabulatedObject<Scalar>::BasicTabulatedObject(const StochasticObject& source, double dEpsilon, std::size_t nMaxSize):
+        nMinimum(source.getIntMinimum()), vDistribution({}), vRunStart({}), vRunOffset({}), dLastCDF(0), nLastValue(nMinimum-1),
+        dErrorBound(std::numeric_limits<Scalar>::digits<std::numeric_limits<double>::digits ? getUnitRoundoff() : .0) {
+    auto nMaximum = source.getIntMaximum();
+    std::size_t nCount = 0;
+    for (std::int64_t n=nMinimum; nCount<nMaxSize; ++n, ++nCount) {
+        double dCDF = source.cdfAt(n);
+        append(n, Scalar(dCDF));
+        if (1.-dCDF<dEpsilon || n>=nMaximum)
+            break;
+    }
+}
+
+template<typename Scalar>
+BasicTabulatedObject<Scalar>::BasicTabulatedObject(double dMinimum_, const std::vector<double>& vMass):
+        BasicTabulatedObject(dMinimum_, vMass.data(), vMass.size()) {
+}
+
+template<typename Scalar>
+BasicTabulatedObject<Scalar>::BasicTabulatedObject(double dMinimum_, const double* pMass, std::size_t nCount):
+        nMinimum(toInteger(dMinimum_, "Tabulated minimum")), vDistribution({}), vRunStart({}), vRunOffset({}), dLastCDF(0), nLastValue(nMinimum-1),
+        dErrorBound((std::numeric_limits<Scalar>::digits<std::numeric_limits<double>::digits ? getUnitRoundoff() : .0)
+                    +getSummationError(getUnitRoundoff(), nCount)) {
+    CompensatedSum<Scalar> cdf;
+    for (std::size_t i=0; i<nCount; ++i) {
+        cdf.add(Scalar(pMass[i]));
+        append(nMinimum+std::int64_t(i), cdf.get());
+    }
+}
+
+template<typename Scalar>
+BasicTabulatedObject<Scalar>::BasicTabulatedObject(std::size_t nRuns, const std::int64_t* pRunStart, const std::uint64_t* pRunLength,
+                                                   const double* pMass):
+        nMinimum(nRuns>0 ? pRunStart[0] : 0), vDistribution({}), vRunStart({}), vRunOffset({}), dLastCDF(0), nLastValue(nMinimum-1),
+        dErrorBound(std::numeric_limits<Scalar>::digits<std::numeric_limits<double>::digits ? getUnitRoundoff() : .0) {
+    CompensatedSum<Scalar> cdf;
+    std::size_t nCount = 0;
+    for (std::size_t nRun=0; nRun<nRuns; ++nRun) {
+        for (std::uint64_t i=0; i<pRunLength[nRun]; ++i) {
+            cdf.add(Scalar(*pMass++));
+            append(pRunStart[nRun]+std::int64_t(i), cdf.get());
+        }
+        nCount += std::size_t(pRunLength[nRun]);
+    }
+    dErrorBound += getSummationError(getUnitRoundoff(), nCount);
+}
+
+template<typename Scalar>
+std::vector<typename BasicTabulatedObject<Scalar>::Run> BasicTabulatedObject<Scalar>::getRuns(void) const {
+    std::vector<Run> vRuns;
+    Scalar dPrevious = 0;
+    for (std::size_t nRun=0; nRun<vRunStart.size(); ++nRun) {
+        vRuns.push_back({vRunStart[nRun], {}});
+        for (std::size_t i=vRunOffset[nRun]; i<getRunEnd(nRun); ++i) {
+            vRuns.back().second.push_back(double(vDistribution[i]-dPrevious));
+            dPrevious = vDistribution[i];
+        }
+    }
+    return vRuns;
+}
+
+template<typename Scalar>
+void BasicTabulatedObject<Scalar>::append(std::int64_t n, Scalar dCDF) {
+    // Values without mass are only stored to fill short gaps inside a run.
+    if (!(dCDF>dLastCDF))
+        return;
+    if (vDistribution.empty()) {
+        nMinimum = n;
+        vRunStart.push_back(n);
+        vRunOffset.push_back(0);
+    } else if (n-nLastValue>nMinimumGap) {
+        vRunStart.push_back(n);
+        vRunOffset.push_back(vDistribution.size());
+    } else {
+        for (auto m=nLastValue+1; m<n; ++m)
+            vDistribution.push_back(dLastCDF);
+    }
+    vDistribution.push_back(dCDF);
+    dLastCDF = dCDF;
+    nLastValue = n;
+}
+
+template<typename Scalar>
+std::size_t BasicTabulatedObject<Scalar>::findRun(std::int64_t n) const {
+    return std::size_t(std::upper_bound(vRunStart.begin(), vRunStart.end(), n)-vRunStart.begin())-1;
+}
+
+template<typename Scalar>
+std::size_t BasicTabulatedObject<Scalar>::getRunEnd(std::size_t nRun) const {
+    return nRun+1<vRunOffset.size() ? vRunOffset[nRun+1] : vDistribution.size();
+}
+
+template<typename Scalar>
+template<typename F>
+void BasicTabulatedObject<Scalar>::forEachMass(F f) const {
+    Scalar dPrevious = 0;
+    for (std::size_t nRun=0; nRun<vRunStart.size(); ++nRun) {
+        for (std::size_t i=vRunOffset[nRun]; i<getRunEnd(nRun); ++i) {
+            Scalar dMass = vDistribution[i]-dPrevious;
+            if (dMass>0)
+                f(vRunStart[nRun]+std::int64_t(i-vRunOffset[nRun]), dMass);
+            dPrevious = vDistribution[i];
+        }
+    }
+    Scalar dTail = vDistribution.empty() ? Scalar(1) : Scalar(1)-vDistribution.back();
+    if (dTail>0)
+        f(addSaturated(nLastValue, 1), dTail);
+}
+
+template<typename Scalar>
+Scalar BasicTabulatedObject<Scalar>::cdfValue(std::int64_t n) const {
+    if (n<nMinimum)
+        return 0;
+    if (vDistribution.empty())
+        return 1;
+    auto nRun = findRun(n);
+    auto nDelta = std::uint64_t(n)-std::uint64_t(vRunStart[nRun]);
+    auto nEnd = getRunEnd(nRun);
+    if (nDelta<nEnd-vRunOffset[nRun])
+        return vDistribution[vRunOffset[nRun]+nDelta];
+    // In the gap after a run nothing changes; after the last run the table ends.
+    return nRun+1==vRunStart.size() ? Scalar(1) : vDistribution[nEnd-1];
+}
+
+template<typename Scalar>
+double BasicTabulatedObject<Scalar>::cdfAt(std::int64_t n) const {
+    return double(cdfValue(n));
+}
+
+template<typename Scalar>
+double BasicTabulatedObject<Scalar>::pmfAt(std::int64_t n) const {
+    if (n<nMinimum)
+        return .0;
+    if (vDistribution.empty())
+        return n==nMinimum ? 1. : .0;
+    auto nRun = findRun(n);
+    auto nDelta = std::uint64_t(n)-std::uint64_t(vRunStart[nRun]);
+    auto nLength = getRunEnd(nRun)-vRunOffset[nRun];
+    if (nDelta<nLength) {
+        auto nIndex = vRunOffset[nRun]+nDelta;
+        return double(nIndex==0 ? vDistribution[0] : vDistribution[nIndex]-vDistribution[nIndex-1]);
+    }
+    return (nRun+1==vRunStart.size() && nDelta==nLength) ? getTailMass() : .0;
+}
+
+template<typename Scalar>
+std::int64_t BasicTabulatedObject<Scalar>::getIntMinimum(void) const {
+    return nMinimum;
+}
+
+template<typename Scalar>
+std::int64_t BasicTabulatedObject<Scalar>::getIntMaximum(void) const {
+    // Lookups beyond the table return 1, so any remaining tail mass sits on the next value
+    if (getTailMass()>.0)
+        return addSaturated(nLastValue, 1);
+    return nLastValue;
+}
+
+template<typename Scalar>
+std::int64_t BasicTabulatedObject<Scalar>::quantile(double dP) const {
+    if (!(dP>=.0 && dP<=1.))
+        throw std::string{"Probability must be between 0 and 1."};
+    auto nIndex = std::size_t(std::lower_bound(vDistribution.begin(), vDistribution.end(), dP,
+            [](Scalar dCDF, double dValue){return Wide<Scalar>(dCDF)<Wide<Scalar>(dValue);})-vDistribution.begin());
+    if (nIndex==vDistribution.size())
+        return addSaturated(nLastValue, 1);
+    auto nRun = std::size_t(std::upper_bound(vRunOffset.begin(), vRunOffset.end(), nIndex)-vRunOffset.begin())-1;
+    return vRunStart[nRun]+std::int64_t(nIndex-vRunOffset[nRun]);
+}
+
+// Exact sums over the stored values, in offsets from the minimum to avoid cancellation.
+template<typename Scalar>
+double BasicTabulatedObject<Scalar>::mean(void) const {
+    Wide<Scalar> dFirst = 0;
+    forEachMass([&](std::int64_t n, Scalar dMass){dFirst += Wide<Scalar>(dMass)*Wide<Scalar>(n-nMinimum);});
+    return double(Wide<Scalar>(nMinimum)+dFirst);
+}
+
+template<typename Scalar>
+double BasicTabulatedObject<Scalar>::variance(void) const {
+    Wide<Scalar> dFirst = 0, dSecond = 0;
+    forEachMass([&](std::int64_t n, Scalar dMass){
+        Wide<Scalar> dOffset = Wide<Scalar>(n-nMinimum);
+        dFirst += Wide<Scalar>(dMass)*dOffset;
+        dSecond += Wide<Scalar>(dMass)*dOffset*dOffset;
+    });
+    return std::max(.0, double(dSecond-dFirst*dFirst));
+}
+
+template<typename Scalar>
+std::size_t BasicTabulatedObject<Scalar>::getSize(void) const {
+    if (vDistribution.empty())
+        return 0;
+    return std::size_t(nLastValue-nMinimum)+1;
+}
+
+template<typename Scalar>
+double BasicTabulatedObject<Scalar>::getTailMass(void) const {
+    if (vDistribution.empty())
+        return 1.;
+    return double(Scalar(1)-vDistribution.back());
+}
+
+template<typename Scalar>
+double BasicTabulatedObject<Scalar>::getUnitRoundoff(void) {
+    return double(std::numeric_limits<Scalar>::epsilon())/2.;
+}
+
+template<typename Scalar>
+std::string BasicTabulatedObject<Scalar>::getScalarName(void) {
+    if (std::is_same<Scalar, float>::value)
+        return "float";
+    return std::is_same<Scalar, double>::value ? "double" : "long double";
+}
+
+template<typename Scalar>
+std::size_t BasicTabulatedObject<Scalar>::getMemoryBytes(void) const {
+    return sizeof(*this)+vDistribution.capacity()*sizeof(Scalar)+vRunStart.capacity()*sizeof(std::int64_t)
+           +vRunOffset.capacity()*sizeof(std::size_t);
+}
+
+template<typename Scalar>
+std::shared_ptr<BasicTabulatedObject<Scalar>> BasicTabulatedObject<Scalar>::truncate(std::size_t nMaxSize) const {
+    if (getSize()<=nMaxSize)
+        return std::make_shared<BasicTabulatedObject>(*this);
+    auto nWidth = std::int64_t(std::max<std::size_t>(nMaxSize, 1))-1;
+    // Try every stored value as the first one of the window.
+    std::int64_t nFirst = nMinimum;
+    Scalar dBestMass = -1, dBelow = 0;
+    for (std::size_t nRun=0; nRun<vRunStart.size(); ++nRun) {
+        for (std::size_t i=vRunOffset[nRun]; i<getRunEnd(nRun); ++i) {
+            auto n = vRunStart[nRun]+std::int64_t(i-vRunOffset[nRun]);
+            Scalar dMass = cdfValue(addSaturated(n, nWidth))-dBelow;
+            if (vDistribution[i]>dBelow && dMass>dBestMass) {
+                dBestMass = dMass;
+                nFirst = n;
+            }
+            dBelow = vDistribution[i];
+        }
+    }
+    std::shared_ptr<BasicTabulatedObject> pTable(new BasicTabulatedObject());
+    pTable->dErrorBound = dErrorBound;
+    auto nLast = addSaturated(nFirst, nWidth);
+    for (std::size_t nRun=0; nRun<vRunStart.size() && vRunStart[nRun]<=nLast; ++nRun) {
+        for (std::size_t i=vRunOffset[nRun]; i<getRunEnd(nRun); ++i) {
+            auto n = vRunStart[nRun]+std::int64_t(i-vRunOffset[nRun]);
+            if (n>=nFirst && n<=nLast)
+                pTable->append(n, vDistribution[i]);
+        }
+    }
+    return pTable;
+}
+
+template<typename Scalar>
+std::string BasicTabulatedObject<Scalar>::getDescription(void) const {
+    std::uint64_t nHash;
+    if (sizeof(Scalar)<=sizeof(double)) {
+        nHash = hashBytes(vDistribution.data(), vDistribution.size()*sizeof(Scalar));
+    } else {
+        // Wider types have padding bytes, so hash each value as a sum of two doubles.
+        std::vector<double> vParts;
+        for (auto dValue: vDistribution) {
+            vParts.push_back(double(dValue));
+            vParts.push_back(double(dValue-Scalar(vParts.back())));
+        }
+        nHash = hashBytes(vParts.data(), vParts.size()*sizeof(double));
+    }
+    if (vRunStart.size()>1)
+        nHash = hashBytes(vRunStart.data(), vRunStart.size()*sizeof(std::int64_t), nHash);
+    std::string sName = std::is_same<Scalar, double>::value ? "Tabulated" : "Tabulated<"+getScalarName()+">";
+    return sName+"("+std::to_string(nMinimum)+","+std::to_string(getSize())+","+std::to_string(nHash)+")";
+}
+
+template<typename Scalar>
+std::shared_ptr<StochasticObject> BasicTabulatedObject<Scalar>::withChildren(const std::vector<std::shared_ptr<StochasticObject>>&) const {
+    return std::make_shared<BasicTabulatedObject>(*this);
+}
+
+template<typename Scalar>
+std::shared_ptr<BasicTabulatedObject<Scalar>> BasicTabulatedObject<Scalar>::fromMasses(std::vector<std::pair<std::int64_t,Scalar>>& vMasses,
+        double dEpsilon, double dInputError) {
+    std::sort(vMasses.begin(), vMasses.end(),
+            [](const std::pair<std::int64_t,Scalar>& a, const std::pair<std::int64_t,Scalar>& b){return a.first<b.first;});
+    std::shared_ptr<BasicTabulatedObject> pTable(new BasicTabulatedObject());
+    pTable->dErrorBound = dInputError+getSummationError(getUnitRoundoff(), vMasses.size());
+    CompensatedSum<Scalar> cdf;
+    for (std::size_t i=0; i<vMasses.size();) {
+        auto n = vMasses[i].first;
+        for (; i<vMasses.size() && vMasses[i].first==n; ++i)
+            cdf.add(vMasses[i].second);
+        Scalar dCDF = std::min(cdf.get(), Scalar(1));
+        pTable->append(n, dCDF);
+        if (1.-double(dCDF)<dEpsilon)
+            break;
+    }
+    return pTable;
+}
+
+// The stored CDF errors carry over to the result through summation by parts; the masses and their
+// products add a rounding each.
+template<typename Scalar>
+std::shared_ptr<BasicTabulatedObject<Scalar>> BasicTabulatedObject<Scalar>::add(const BasicTabulatedObject& left, const BasicTabulatedObject& right,
+        double dEpsilon) {
+    std::vector<std::pair<std::int64_t,Scalar>> vRight;
+    right.forEachMass([&](std::int64_t n, Scalar dMass){vRight.emplace_back(n, dMass);});
+    std::size_t nLeftCount = 0;
+    left.forEachMass([&](std::int64_t, Scalar){++nLeftCount;});
+    double dInputError = left.dErrorBound+right.dErrorBound+3.*getUnitRoundoff();
+    std::vector<std::pair<std::int64_t,Scalar>> vMasses;
+    auto nLow = addSaturated(left.getIntMinimum(), right.getIntMinimum());
+    double dSpan = double(left.getIntMaximum())+double(right.getIntMaximum())-double(nLow)+1.;
+    if (dSpan<=double(nLeftCount)*double(vRight.size())) {
+        // Dense results (the usual case) are summed in place, which needs neither the pairs nor a sort.
+        // Each value adds up to min(nLeftCount, vRight.size()) products without compensation.
+        std::vector<Scalar> vDense(std::size_t(dSpan), Scalar(0));
+        left.forEachMass([&](std::int64_t nLeft, Scalar dLeft){
+            auto nOffset = std::size_t(nLeft-left.getIntMinimum());
+            for (auto &r: vRight)
+                vDense[nOffset+std::size_t(r.first-right.getIntMinimum())] += dLeft*r.second;
+        });
+        for (std::size_t i=0; i<vDense.size(); ++i)
+            if (vDense[i]>0)
+                vMasses.emplace_back(nLow+std::int64_t(i), vDense[i]);
+        dInputError += double(std::min(nLeftCount, vRight.size()))*getUnitRoundoff();
+    } else {
+        left.forEachMass([&](std::int64_t nLeft, Scalar dLeft){
+            for (auto &r: vRight)
+                vMasses.emplace_back(addSaturated(nLeft, r.first), dLeft*r.second);
+        });
+    }
+    return fromMasses(vMasses, dEpsilon, dInputError);
+}
+
+template<typename Scalar>
+std::shared_ptr<BasicTabulatedObject<Scalar>> BasicTabulatedObject<Scalar>::maximum(const BasicTabulatedObject& first,
+        const BasicTabulatedObject& second, double dEpsilon) {
+    // The CDF of the maximum is the product of both CDFs, which only changes where one of them does.
+    std::vector<std::int64_t> vPoints;
+    first.forEachMass([&](std::int64_t n, Scalar){vPoints.push_back(n);});
+    second.forEachMass([&](std::int64_t n, Scalar){vPoints.push_back(n);});
+    std::sort(vPoints.begin(), vPoints.end());
+    vPoints.erase(std::unique(vPoints.begin(), vPoints.end()), vPoints.end());
+    std::vector<std::pair<std::int64_t,Scalar>> vMasses;
+    Scalar dPrevious = 0;
+    for (auto n: vPoints) {
+        Scalar dCDF = first.cdfValue(n)*second.cdfValue(n);
+        vMasses.emplace_back(n, dCDF-dPrevious);
+        dPrevious = dCDF;
+    }
+    return fromMasses(vMasses, dEpsilon, first.dErrorBound+second.dErrorBound+2.*getUnitRoundoff());
+}
+
+template<typename Scalar>
+std::shared_ptr<BasicTabulatedObject<Scalar>> BasicTabulatedObject<Scalar>::mix(const std::vector<std::pair<double, const BasicTabulatedObject*>>& vComponents,
+        double dEpsilon) {
+    std::vector<std::pair<std::int64_t,Scalar>> vMasses;
+    double dInputError = .0;
+    for (auto &component: vComponents) {
+        Scalar dWeight = Scalar(component.first);
+        if (dWeight>0) {
+            component.second->forEachMass([&](std::int64_t n, Scalar dMass){vMasses.emplace_back(n, dWeight*dMass);});
+            dInputError = std::max(dInputError, component.second->dErrorBound);
+        }
+    }
+    return fromMasses(vMasses, dEpsilon, dInputError+3.*getUnitRoundoff());
+}
+
+template class BasicTabulatedObject<float>;
+template class BasicTabulatedObject<double>;
+template class BasicTabulatedObject<long double>;
@@ -0,0 +1,113 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __TABULATEDOBJECT_H__
+#define __TABULATEDOBJECT_H__
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "StochasticObject.h"
+
+// Stores the distribution function of an integer valued StochasticObject from its minimum up to the
+// point where less than dEpsilon probability is left. Lookups beyond the table return 1.
+//
+// Values are stored in runs of consecutive integers. Stretches of at least nMinimumGap values
+// without probability end a run and are not stored at all, so supports with large gaps or a few
+// isolated spikes (e.g. a miss at 0 mixed with a far away damage tail) stay small, while ordinary
+// distributions are a single dense run. add, maximum and mix work on the stored values only.
+//
+// Scalar is the type of the stored values and of the arithmetic in add, maximum and mix, which sum
+// with compensation. TabulatedObject (double) is what the rest of the engine uses; float halves the
+// memory of large tables, long double keeps more digits through long chains of additions.
+// getErrorBound tracks how far the stored distribution function may be off through rounding.
+template<typename Scalar>
+class BasicTabulatedObject: public StochasticObject {
+    private:
+        std::int64_t nMinimum;
+        std::vector<Scalar> vDistribution; // CDF at every stored value
+        std::vector<std::int64_t> vRunStart; // first value of each run
+        std::vector<std::size_t> vRunOffset; // index of that value in vDistribution
+        Scalar dLastCDF;
+        std::int64_t nLastValue;
+        double dErrorBound;
+        static const std::int64_t nMinimumGap = 16;
+
+        BasicTabulatedObject(void);
+        void append(std::int64_t n, Scalar dCDF);
+        std::size_t findRun(std::int64_t n) const;
+        std::size_t getRunEnd(std::size_t nRun) const;
+        Scalar cdfValue(std::int64_t n) const;
+        // Calls f(value, mass) for every stored value with mass and for the tail beyond the table.
+        template<typename F> void forEachMass(F f) const;
+        static std::shared_ptr<BasicTabulatedObject> fromMasses(std::vector<std::pair<std::int64_t,Scalar>>& vMasses, double dEpsilon, double dInputError);
+    public:
+        BasicTabulatedObject(const StochasticObject& source, double dEpsilon=1e-9, std::size_t nMaxSize=1<<20);
+        BasicTabulatedObject(double dMinimum_, const std::vector<double>& vMass);
+        BasicTabulatedObject(double dMinimum_, const double* pMass, std::size_t nCount);
+        // Table from nRuns runs of masses starting at pRunStart[i] with pRunLength[i] values each; pMass
+        // holds all runs back to back, e.g. as DistributionCache stores them.
+        BasicTabulatedObject(std::size_t nRuns, const std::int64_t* pRunStart, const std::uint64_t* pRunLength, const double* pMass);
+        virtual ~BasicTabulatedObject(void) = default;
+
+        virtual double cdfAt(std::int64_t n) const;
+        virtual double pmfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual std::int64_t quantile(double dP) const;
+        virtual double mean(void) const;
+        virtual double variance(void) const;
+        virtual std::string getDescription(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
+
+        // Number of values from the minimum to the last tabulated one, gaps included.
+        std::size_t getSize(void) const;
+        std::size_t getStoredSize(void) const {return vDistribution.size();};
+        std::size_t getRunCount(void) const {return vRunStart.size();};
+        // Masses of the stored runs, each with its first value. Values between runs have no mass and
+        // the tail (getTailMass) is left out, so this needs memory for getStoredSize values only.
+        typedef std::pair<std::int64_t, std::vector<double>> Run;
+        std::vector<Run> getRuns(void) const;
+        double getTailMass(void) const;
+        // Bound on the rounding error of every stored CDF value, on top of the errors of the source
+        // object a table was made from. The truncated tail (getTailMass) is not included.
+        double getErrorBound(void) const {return dErrorBound;};
+        // Unit roundoff of Scalar.
+        static double getUnitRoundoff(void);
+        static std::string getScalarName(void);
+        // Heap and object memory held by the table.
+        std::size_t getMemoryBytes(void) const;
+        // Copy restricted to the nMaxSize consecutive values (see getSize) that hold the most mass. Mass
+        // below them moves onto the first kept value, mass above into the tail.
+        std::shared_ptr<BasicTabulatedObject> truncate(std::size_t nMaxSize) const;
+
+        // Distributions of the sum and the maximum of independent tables, and the mixture that picks
+        // each table with the given probability. add needs memory for the smaller of the result's
+        // span and the number of value pairs.
+        static std::shared_ptr<BasicTabulatedObject> add(const BasicTabulatedObject& left, const BasicTabulatedObject& right, double dEpsilon=1e-9);
+        static std::shared_ptr<BasicTabulatedObject> maximum(const BasicTabulatedObject& first, const BasicTabulatedObject& second, double dEpsilon=1e-9);
+        static std::shared_ptr<BasicTabulatedObject> mix(const std::vector<std::pair<double, const BasicTabulatedObject*>>& vComponents, double dEpsilon=1e-9);
+};
+
+extern template class BasicTabulatedObject<float>;
+extern template class BasicTabulatedObject<double>;
+extern template class BasicTabulatedObject<long double>;
+
+#endif
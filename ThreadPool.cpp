@@ -0,0 +1,72 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(std::size_t nThreads_): nActive(0), bStopping(false) {
+    if (nThreads_==0)
+        nThreads_ = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i=0; i<nThreads_; ++i)
+        vWorkers.emplace_back([this](){this->workerLoop();});
+}
+
+ThreadPool::~ThreadPool(void) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        bStopping = true;
+    }
+    cvTaskAvailable.notify_all();
+    for (auto &worker: vWorkers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void(void)> task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        qTasks.push_back(std::move(task));
+    }
+    cvTaskAvailable.notify_one();
+}
+
+void ThreadPool::wait(void) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cvIdle.wait(lock, [this](){return qTasks.empty() && nActive==0;});
+}
+
+void ThreadPool::workerLoop(void) {
+    while (true) {
+        std::function<void(void)> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cvTaskAvailable.wait(lock, [this](){return bStopping || !qTasks.empty();});
+            if (qTasks.empty())
+                return;
+            task = std::move(qTasks.front());
+            qTasks.pop_front();
+            ++nActive;
+        }
+        task();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            --nActive;
+            if (qTasks.empty() && nActive==0)
+                cvIdle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed number of worker threads processing a shared FIFO of tasks.
+class ThreadPool {
+    private:
+        std::vector<std::thread> vWorkers;
+        std::deque<std::function<void(void)>> qTasks;
+        std::mutex mutex;
+        std::condition_variable cvTaskAvailable;
+        std::condition_variable cvIdle;
+        std::size_t nActive;
+        bool bStopping;
+
+        void workerLoop(void);
+    public:
+        // nThreads_ = 0 uses one thread per hardware thread.
+        ThreadPool(std::size_t nThreads_=0);
+        ~ThreadPool(void);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void(void)> task);
+        // Blocks until all submitted tasks have finished.
+        void wait(void);
+
+        std::size_t getThreadCount(void) const {return vWorkers.size();};
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <chrono>
+
+#include "WorkStealingPool.h"
+
+namespace {
+    // Pool and queue index of the worker running on the current thread.
+    thread_local const WorkStealingPool* pCurrentPool = nullptr;
+    thread_local std::size_t nCurrentWorker = 0;
+}
+
+WorkStealingPool::WorkStealingPool(std::size_t nThreads_): nPending(0), bStopping(false) {
+    if (nThreads_==0)
+        nThreads_ = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i=0; i<=nThreads_; ++i)
+        vQueues.push_back(std::make_unique<TaskQueue>());
+    for (std::size_t i=0; i<nThreads_; ++i)
+        vWorkers.emplace_back([this, i](){this->workerLoop(i);});
+}
+
+WorkStealingPool::~WorkStealingPool(void) {
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        bStopping = true;
+    }
+    cvWork.notify_all();
+    for (auto &worker: vWorkers)
+        worker.join();
+}
+
+std::shared_ptr<WorkStealingPool> WorkStealingPool::getDefault(void) {
+    static std::shared_ptr<WorkStealingPool> pDefault = std::make_shared<WorkStealingPool>();
+    return pDefault;
+}
+
+void WorkStealingPool::submit(std::function<void(void)> task) {
+    std::size_t nQueue = (pCurrentPool==this)?nCurrentWorker:vQueues.size()-1;
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        ++nPending;
+    }
+    {
+        std::unique_lock<std::mutex> lock(vQueues[nQueue]->mutex);
+        vQueues[nQueue]->qTasks.push_back(std::move(task));
+    }
+    cvWork.notify_one();
+}
+
+bool WorkStealingPool::popLocal(std::size_t nWorker, std::function<void(void)>& task) {
+    auto &queue = *vQueues[nWorker];
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    if (queue.qTasks.empty())
+        return false;
+    task = std::move(queue.qTasks.back());
+    queue.qTasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(std::size_t nWorker, std::function<void(void)>& task) {
+    for (std::size_t i=1; i<=vQueues.size(); ++i) {
+        auto &queue = *vQueues[(nWorker+i)%vQueues.size()];
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        if (queue.qTasks.empty())
+            continue;
+        task = std::move(queue.qTasks.front());
+        queue.qTasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(std::size_t nWorker) {
+    pCurrentPool = this;
+    nCurrentWorker = nWorker;
+    while (true) {
+        std::function<void(void)> task;
+        if (popLocal(nWorker, task) || steal(nWorker, task)) {
+            --nPending;
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (bStopping && nPending==0)
+            return;
+        // The timeout only guards against missed wake-ups; submit() notifies under sleepMutex.
+        cvWork.wait_for(lock, std::chrono::milliseconds(10), [this](){return bStopping || nPending>0;});
+    }
+}
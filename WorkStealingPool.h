@@ -0,0 +1,65 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __WORKSTEALINGPOOL_H__
+#define __WORKSTEALINGPOOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool in which every worker has its own task deque. Tasks submitted from a worker go to
+// the back of its own deque and are run last in, first out; idle workers steal from the front of
+// the other deques. Tasks submitted from other threads are shared by all workers.
+// Tasks must not block waiting for other tasks of the same pool.
+class WorkStealingPool {
+    private:
+        struct TaskQueue {
+            std::mutex mutex;
+            std::deque<std::function<void(void)>> qTasks;
+        };
+
+        std::vector<std::unique_ptr<TaskQueue>> vQueues; // one per worker, the last one for outside submissions
+        std::vector<std::thread> vWorkers;
+        std::atomic<std::size_t> nPending;
+        std::atomic<bool> bStopping;
+        std::mutex sleepMutex;
+        std::condition_variable cvWork;
+
+        bool popLocal(std::size_t nWorker, std::function<void(void)>& task);
+        bool steal(std::size_t nWorker, std::function<void(void)>& task);
+        void workerLoop(std::size_t nWorker);
+    public:
+        // nThreads_ = 0 uses one thread per hardware thread.
+        WorkStealingPool(std::size_t nThreads_=0);
+        ~WorkStealingPool(void);
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        void submit(std::function<void(void)> task);
+        std::size_t getThreadCount(void) const {return vWorkers.size();};
+
+        // Pool shared by all users that do not bring their own.
+        static std::shared_ptr<WorkStealingPool> getDefault(void);
+};
+
+#endif
@@ -15,39 +15,59 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
-#include <cmath>
-
-#include "FlatMod.h"
-#include "RaiseCounter.h"
+#include <algorithm>
 
 #include "WoundCalculatorObject.h"
+#include "ImportanceSampler.h"
 
 
 WoundCalculatorObject::WoundCalculatorObject(const std::shared_ptr<StochasticObject>& pDamage_, double dToughness_, bool bShaken_) :
-        pDamage(pDamage_), dToughness(dToughness_), bShaken(bShaken_) {}
+        pDamage(pDamage_), nToughness(toInteger(dToughness_, "Toughness")), bShaken(bShaken_) {}
 
-double WoundCalculatorObject::distributionFunction(double dX) const {
-    if(dX<.0)
+double WoundCalculatorObject::cdfAt(std::int64_t n) const {
+    if(n<0)
         return .0;
-    double dIntegerPartOfX{.0};
-    std::modf(dX, &dIntegerPartOfX);
+    // A shaken target takes a wound from a plain success, an unshaken one needs a raise
+    if(n==0)
+        return pDamage->cdfAt(addSaturated(nToughness, bShaken?-1:3));
+    if(n>(nUnbounded-3)/4)
+        return 1.;
+    return pDamage->cdfAt(addSaturated(n*4+3, nToughness));
+}
+
+std::int64_t WoundCalculatorObject::woundsFromDamage(std::int64_t nDamage, std::int64_t nToughness, bool bShaken) {
+    if (nDamage>=addSaturated(nToughness, 4))
+        return (nDamage-nToughness)/4;
+    return (bShaken && nDamage>=nToughness) ? 1 : 0;
+}
+
+std::int64_t WoundCalculatorObject::getIntMinimum(void) const {
+    return 0;
+}
 
-    auto normalizedRoll = std::make_shared<FlatMod>(pDamage, 4.0-dToughness);
-    auto raiseCounter = std::make_shared<RaiseCounter>(normalizedRoll);
-    if((!bShaken) || (dX>=2.)) {
-        return raiseCounter->distributionFunction(dX+1.);
-    } else {
-        if(dX<1.) {
-            return normalizedRoll->distributionFunction(3.);
-        }
-        else {
-            return normalizedRoll->distributionFunction(11.);
-        }
-    }
-    return .0;
+std::int64_t WoundCalculatorObject::sample(ImportanceSampler& sampler) const {
+    return woundsFromDamage(pDamage->sample(sampler), nToughness, bShaken);
 }
 
-double WoundCalculatorObject::getMinimum(void) const {
-    return .0;
+std::int64_t WoundCalculatorObject::getIntMaximum(void) const {
+    auto nMaximum = pDamage->getIntMaximum();
+    if (nMaximum==nUnbounded)
+        return nUnbounded;
+    if (nMaximum<addSaturated(nToughness, bShaken?0:4))
+        return 0;
+    // Smallest n with 4n+3+T >= nMaximum
+    auto nExcess = nMaximum-3-nToughness;
+    return std::max<std::int64_t>(1, nExcess<=0 ? 0 : (nExcess+3)/4);
 }
 
+std::string WoundCalculatorObject::getDescription(void) const {
+    return "Wounds("+pDamage->getDescription()+","+std::to_string(nToughness)+","+(bShaken?"shaken":"unshaken")+")";
+}
+
+std::vector<std::shared_ptr<StochasticObject>> WoundCalculatorObject::getChildren(void) const {
+    return {pDamage};
+}
+
+std::shared_ptr<StochasticObject> WoundCalculatorObject::withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const {
+    return std::make_shared<WoundCalculatorObject>(vChildren.at(0), double(nToughness), bShaken);
+}
@@ -24,17 +24,25 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 class WoundCalculatorObject: public StochasticObject {
     private:
         std::shared_ptr<StochasticObject> pDamage;
-        double dToughness;
+        std::int64_t nToughness;
         bool bShaken;
     public:
         WoundCalculatorObject(const std::shared_ptr<StochasticObject>& pDamage, double dToughness, bool bShaken);
         virtual ~WoundCalculatorObject(void) = default;
 
-        virtual double distributionFunction(double dX_) const;
-        virtual double getMinimum(void) const;
+        virtual double cdfAt(std::int64_t n) const;
+        virtual std::int64_t getIntMinimum(void) const;
+        virtual std::int64_t getIntMaximum(void) const;
+        virtual std::int64_t sample(ImportanceSampler& sampler) const;
+        virtual std::string getDescription(void) const;
+        virtual std::vector<std::shared_ptr<StochasticObject>> getChildren(void) const;
+        virtual std::shared_ptr<StochasticObject> withChildren(const std::vector<std::shared_ptr<StochasticObject>>& vChildren) const;
 
-        double getToughness(void) const {return dToughness;};
-        void setToughness(double dToughness_) {dToughness=dToughness_;};
+        double getToughness(void) const {return double(nToughness);};
+        void setToughness(double dToughness_) {nToughness=toInteger(dToughness_, "Toughness");};
+
+        // Wounds caused by a single damage total, matching cdfAt.
+        static std::int64_t woundsFromDamage(std::int64_t nDamage, std::int64_t nToughness, bool bShaken);
 
         bool isShaken(void) const {return bShaken;};
         void setShaken(bool bShaken_) {bShaken = bShaken_;};
@@ -16,35 +16,104 @@ You should have received a copy of the GNU General Public License
 along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include <string>
+#include <vector>
+#include <random>
 #include <iostream>
+#include <fstream>
 #include <iomanip>
 #include <memory>
 #include <cmath>
+#include <algorithm>
 #include "AcingDie.h"
 #include "MaxConnector.h"
 #include "RaiseCounter.h"
 #include "FlatMod.h"
 #include "SWTraitRoll.h"
+#include "RerollSolver.h"
+#include "ImportanceSampler.h"
+#include "DistributionCache.h"
+#include "BatchProcessor.h"
 
 int main(int argc, char* argv[]) {
-    if(argc == 1) {
-        std::cout << "Usage:\n"<<argv[0]<<" TraitDie [Modifier] [WildDie] [Rerolls]" << std::endl;
+    // Query options may appear anywhere, the remaining arguments are positional.
+    std::vector<std::string> vArguments;
+    std::vector<double> vQuantiles;
+    std::vector<double> vMinimumModifiers;
+    long nLevel = 1;
+    long nBennies = -1;
+    long nSimulations = 0;
+    double dBias = -1.;
+    bool bBatch = false;
+    std::string sFormat{"csv"};
+    long nThreads = 0;
+    for (int i=1; i<argc; ++i) {
+        std::string sArgument{argv[i]};
+        bool bHasValue = i+1<argc;
+        if (sArgument=="--quantile" && bHasValue)
+            vQuantiles.push_back(std::stod(std::string{argv[++i]}));
+        else if (sArgument=="--min-mod" && bHasValue)
+            vMinimumModifiers.push_back(std::stod(std::string{argv[++i]}));
+        else if (sArgument=="--bennies" && bHasValue)
+            nBennies = std::stol(std::string{argv[++i]});
+        else if (sArgument=="--simulate" && bHasValue)
+            nSimulations = std::stol(std::string{argv[++i]});
+        else if (sArgument=="--bias" && bHasValue)
+            dBias = std::stod(std::string{argv[++i]});
+        else if (sArgument=="--level" && bHasValue)
+            nLevel = std::stol(std::string{argv[++i]});
+        else if (sArgument=="--batch")
+            bBatch = true;
+        else if (sArgument=="--format" && bHasValue)
+            sFormat = argv[++i];
+        else if (sArgument=="--threads" && bHasValue)
+            nThreads = std::stol(std::string{argv[++i]});
+        else
+            vArguments.push_back(sArgument);
+    }
+    if(bBatch && (sFormat=="csv" || sFormat=="json") && nThreads>=0 && vArguments.size()<=1) {
+        // Only the reader thread touches the input, so the C stdio synchronization is not needed.
+        std::ios::sync_with_stdio(false);
+        BatchProcessor processor(sFormat=="json" ? BatchProcessor::Format::JSON : BatchProcessor::Format::CSV, (std::size_t)nThreads);
+        if (vArguments.empty() || vArguments[0]=="-") {
+            processor.run(std::cin, std::cout);
+        } else {
+            std::ifstream input(vArguments[0]);
+            if (!input) {
+                std::cerr << "Could not open "<<vArguments[0] << std::endl;
+                return 1;
+            }
+            processor.run(input, std::cout);
+        }
+        return 0;
+    }
+    if(vArguments.empty() || bBatch) {
+        std::cout << "Usage:\n"<<argv[0]<<" TraitDie [Modifier] [WildDie] [Rerolls] [Options]\n"
+                  << "       "<<argv[0]<<" --batch [File] [--format csv|json] [--threads N]\n"
+                  << "Options:\n"
+                  << "  --quantile P   fewest Successes & Raises that are not exceeded with P%\n"
+                  << "  --min-mod P    smallest Modifier that gives at least LEVEL Successes & Raises with P%\n"
+                  << "  --bennies N    best use of N Bennies instead of Rerolls, for LEVEL and for most Successes & Raises\n"
+                  << "  --simulate N   estimate the chance of at least LEVEL Successes & Raises from N samples\n"
+                  << "  --bias P       let dice explode with P (0 to 1) while simulating, by default chosen from LEVEL\n"
+                  << "  --level LEVEL  Successes & Raises needed for --min-mod, --bennies and --simulate (default 1)\n"
+                  << "  --batch        read one \"TraitDie [Modifier] [WildDie] [Rerolls]\" per line from File (default: standard input)\n"
+                  << "                 and write one result per line; --threads N sets the compute threads (default: all)" << std::endl;
         return 1;
     }
     unsigned int nDieSides1{4},nDieSides2{6};
     double dMod = .0;
     unsigned int nRerolls{0};
-    if(argc>1) {
-        nDieSides1 = std::stoul(std::string{argv[1]});
+    if(vArguments.size()>0) {
+        nDieSides1 = std::stoul(vArguments[0]);
     }
-    if(argc>2) {
-        dMod = std::stod(std::string{argv[2]});
+    if(vArguments.size()>1) {
+        dMod = std::stod(vArguments[1]);
     }
-    if(argc>3) {
-        nDieSides2 = std::stoul(std::string{argv[3]});
+    if(vArguments.size()>2) {
+        nDieSides2 = std::stoul(vArguments[2]);
     }
-    if(argc>4) {
-        nRerolls = std::stoul(std::string{argv[4]});
+    if(vArguments.size()>3) {
+        nRerolls = std::stoul(vArguments[3]);
     }
     if (nDieSides1 <= 1) {
         std::cout << "Please give a positive, integer number greater than 1 as first parameter." << std::endl;
@@ -53,21 +122,76 @@ int main(int argc, char* argv[]) {
     SWTraitRoll fullTraitRoll(nDieSides1, nDieSides2, dMod);
     std::cout << "Rolling D"<<nDieSides1<<" and D"<<nDieSides2<<" +"<<dMod<<" "<<nRerolls+1<<" times." << std::endl;
     fullTraitRoll.setRerolls(nRerolls);
+    DistributionCache cache;
+    auto pTable = cache.getTabulated(fullTraitRoll);
+
+    if(!vQuantiles.empty() || !vMinimumModifiers.empty() || nBennies>=0 || nSimulations>0) {
+        try {
+            if (nSimulations>0) {
+                if (dBias<.0) {
+                    // About as many explosions of the trait die as LEVEL needs.
+                    double dExplosions = std::max(.0, (4.*double(nLevel)-dMod)/double(nDieSides1)-1.);
+                    dBias = std::min(.9, dExplosions/(dExplosions+1.));
+                }
+                ImportanceSampler sampler(dBias, std::random_device{}());
+                auto estimate = sampler.estimate(fullTraitRoll, nLevel, (std::size_t)nSimulations);
+                std::cout << "Simulated probability of at least "<<nLevel<<" Successes & Raises: "<<std::setprecision(4)
+                          << 100.*estimate.dProbability<<"% (95% confidence "<<100.*estimate.dLower<<"% to "<<100.*estimate.dUpper<<"%, "
+                          << estimate.nHits<<" of "<<estimate.nSamples<<" samples with explosion chance "<<dBias<<")" << std::endl;
+                std::cout << "Exact: "<<100.*(1.-pTable->distributionFunction(double(nLevel-1)))<<"%" << std::endl;
+                std::cout << resetiosflags(std::ios_base::floatfield);
+            }
+            if (nBennies>=0) {
+                RerollSolver levelSolver(fullTraitRoll, (unsigned int)nBennies, RerollSolver::atLeast(nLevel));
+                RerollSolver countSolver(fullTraitRoll, (unsigned int)nBennies, RerollSolver::successesAndRaises());
+                std::cout << "Spending up to "<<nBennies<<" Bennies optimally:" << std::endl;
+                std::cout << "  Probability of at least "<<nLevel<<" Successes & Raises: "<<std::fixed<<std::setprecision(2)
+                          << 100.*levelSolver.getExpectedUtility()<<"%" << std::endl;
+                std::cout << "  Expected Successes & Raises: "<<countSolver.getExpectedUtility() << std::endl;
+                std::cout << resetiosflags(std::ios_base::floatfield);
+                for (long b=nBennies; b>0; --b) {
+                    std::int64_t nRerollUpTo = -1;
+                    for (std::int64_t s=0; s<=countSolver.getTopLevel(); ++s)
+                        if (countSolver.shouldReroll((unsigned int)b, s))
+                            nRerollUpTo = s;
+                    std::cout << "  With "<<b<<" Bennies left, for most Successes & Raises reroll ";
+                    if (nRerollUpTo<0)
+                        std::cout << "never" << std::endl;
+                    else
+                        std::cout << "at "<<nRerollUpTo<<" Successes & Raises or less" << std::endl;
+                }
+            }
+            for (auto dPercent: vQuantiles) {
+                std::cout << "With "<<dPercent<<"% probability no more than "<<pTable->quantile(dPercent/100.)
+                          << " Successes & Raises" << std::endl;
+            }
+            for (auto dPercent: vMinimumModifiers) {
+                int nMinimumMod = fullTraitRoll.findMinimumModifier(dPercent/100., nLevel);
+                std::cout << "Minimum Modifier for at least "<<nLevel<<" Successes & Raises with "<<dPercent<<"%: "
+                          << std::showpos<<nMinimumMod<<std::noshowpos
+                          << " (highest Target Number at "<<std::showpos<<dMod<<std::noshowpos<<": "<<4+int(dMod)-nMinimumMod<<")" << std::endl;
+            }
+        } catch (const std::string& sError) {
+            std::cout << "Error: "<<sError << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    std::cout << "Probability of Critical Failure: "<<std::fixed << /*std::setprecision(2) << */100.*fullTraitRoll.distributionFunction(-1.)<< " %" << std::endl;
-    std::cout << "Probability of Failure: "<<std::fixed << /*std::setprecision(2) << */ 100.*fullTraitRoll.distributionFunction(.0)<<" %"<<std::endl;
+    std::cout << "Probability of Critical Failure: "<<std::fixed << /*std::setprecision(2) << */100.*pTable->distributionFunction(-1.)<< " %" << std::endl;
+    std::cout << "Probability of Failure: "<<std::fixed << /*std::setprecision(2) << */ 100.*pTable->distributionFunction(.0)<<" %"<<std::endl;
     std::cout << resetiosflags(std::ios_base::floatfield);
     double lastProb = 1.;
     double x = 1.;
     while (lastProb>.01) {
         std::cout << "Probability of no more than "<<std::noshowpos<<x<<" Successes & Raises:  ";
-        std::cout << std::fixed << std::setprecision(2) << 100.0*fullTraitRoll.distributionFunction(x) << "%"<<std::endl;
+        std::cout << std::fixed << std::setprecision(2) << 100.0*pTable->distributionFunction(x) << "%"<<std::endl;
         std::cout << "Probability of at least "<<std::noshowpos<<x<<" Successes & Raises:  ";
-        std::cout << std::fixed << std::setprecision(2) << 100.0*(1.-fullTraitRoll.distributionFunction(x-1.)) << "%"<<std::endl;
+        std::cout << std::fixed << std::setprecision(2) << 100.0*(1.-pTable->distributionFunction(x-1.)) << "%"<<std::endl;
         std::cout << "Probability of exactly "<<std::noshowpos<<x<<" Successes & Raises:  ";
-        std::cout << std::fixed << std::setprecision(2) << 100.0*(fullTraitRoll.distributionFunction(x)-fullTraitRoll.distributionFunction(x-1.)) << "%"<<std::endl;
+        std::cout << std::fixed << std::setprecision(2) << 100.0*(pTable->distributionFunction(x)-pTable->distributionFunction(x-1.)) << "%"<<std::endl;
         std::cout << resetiosflags(std::ios_base::floatfield);
-        lastProb = (1.-fullTraitRoll.distributionFunction(x-1.));
+        lastProb = (1.-pTable->distributionFunction(x-1.));
         ++x;
     }
 
@@ -17,62 +17,143 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 */
 #include <string>
 #include <iostream>
-#include <algorithm>
 #include <iomanip>
+#include <sstream>
 #include <memory>
-#include <cmath>
-#include "AcingDie.h"
-#include "MaxConnector.h"
-#include "RaiseCounter.h"
-#include "FlatMod.h"
-#include "BranchObject.h"
-#include "ConstantObject.h"
-#include "AdderObject.h"
-#include "WoundCalculatorObject.h"
-
-
-int main(int argc, char* argv[]) {
-    unsigned int nDieSides1 = 4;
-    unsigned int nDieSides2 = 6;
-
-    unsigned int nDmgDieSides1 = 8;
-    unsigned int nDmgDieSides2 = 6;
-    unsigned int nDmgDieRaise = 6;
-    double dMod = 0.;
-
-    auto pAttackDie1 = std::make_shared<AcingDie>(nDieSides1);
-    auto pAttackDie2 = std::make_shared<AcingDie>(nDieSides2);
-    auto pAttackMaxConnector = std::make_shared<MaxConnector>(pAttackDie1, pAttackDie2);
-    auto pAttackModdedRoll = std::make_shared<FlatMod>(pAttackMaxConnector,dMod);
-    auto pAttackRaiseCounter = std::make_shared<RaiseCounter>(pAttackModdedRoll);
+#include <vector>
+#include "AttackPipeline.h"
+#include "DistributionCache.h"
 
+unsigned int parseDie(const std::string& sDie) {
+    if (!sDie.empty() && (sDie[0]=='d' || sDie[0]=='D'))
+        return std::stoul(sDie.substr(1));
+    return std::stoul(sDie);
+}
 
-    auto pDmgDie1 = std::make_shared<AcingDie>(nDmgDieSides1);
-    auto pDmgDie2 = std::make_shared<AcingDie>(nDmgDieSides2);
-    auto pDmgDieRaise = std::make_shared<AcingDie>(nDmgDieRaise);
+void printUsage(const char* sName) {
+    std::cout << "Usage:\n"<<sName<<" [-a AttackDie] [-w WildDie] [-m Modifier] [-d DamageDie]... [-r RaiseDie] [-t Toughness]... [-s|-u] [-j] [-M Megabytes]" << std::endl;
+    std::cout << "  -w 0 rolls no Wild Die, -r 0 adds no extra damage on a raise, -s attacks a shaken target (default), -u one that is not." << std::endl;
+    std::cout << "  -j also shows how likely each number of wounds is together with a hit or a raise." << std::endl;
+    std::cout << "  -M keeps the tables within the given memory, cutting off improbable values if needed,\n"
+              << "     and prints the probability cut off." << std::endl;
+    std::cout << "  Defaults: -a d4 -w d6 -m 0 -d d8 -d d6 -r d6 -t 4" << std::endl;
+}
 
-    auto pTotalDmg = std::make_shared<AdderObject>(pDmgDie1, pDmgDie2);
-    auto pTotalRaiseDmg = std::make_shared<AdderObject>(pTotalDmg, pDmgDieRaise);
-    auto pNoHitDmg = std::make_shared<ConstantObject>(.0);
+int main(int argc, char* argv[]) {
+    unsigned int nAttackDieSides{4};
+    unsigned int nWildDieSides{6};
+    double dMod{.0};
+    std::vector<unsigned int> vDamageDice;
+    unsigned int nRaiseDieSides{6};
+    std::vector<double> vToughness;
+    bool bShaken{true};
+    bool bJoint{false};
+    double dMemoryBudget{.0};
 
-    bool bShaken = true;
-    auto pWoundCalculator = std::make_shared<WoundCalculatorObject>(pTotalDmg, 4, bShaken);
-    auto pWoundAfterRaiseCalculator = std::make_shared<WoundCalculatorObject>(pTotalRaiseDmg, 4, bShaken);
+    try {
+        for (int i=1; i<argc; ++i) {
+            std::string sArg{argv[i]};
+            if (sArg=="-s" || sArg=="-u") {
+                bShaken = sArg=="-s";
+                continue;
+            }
+            if (sArg=="-j") {
+                bJoint = true;
+                continue;
+            }
+            if (sArg=="-h" || sArg=="--help" || i+1>=argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            std::string sValue{argv[++i]};
+            if (sArg=="-a")
+                nAttackDieSides = parseDie(sValue);
+            else if (sArg=="-w")
+                nWildDieSides = parseDie(sValue);
+            else if (sArg=="-m")
+                dMod = std::stod(sValue);
+            else if (sArg=="-d")
+                vDamageDice.push_back(parseDie(sValue));
+            else if (sArg=="-r")
+                nRaiseDieSides = parseDie(sValue);
+            else if (sArg=="-t")
+                vToughness.push_back(std::stod(sValue));
+            else if (sArg=="-M")
+                dMemoryBudget = std::stod(sValue);
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (vDamageDice.empty())
+        vDamageDice = {8, 6};
+    if (vToughness.empty())
+        vToughness.push_back(4.);
+    if (nAttackDieSides<=1) {
+        std::cout << "Please give a positive, integer number greater than 1 as attack die." << std::endl;
+        return 1;
+    }
 
-    auto branchObject = std::make_shared<BranchObject>(pAttackRaiseCounter, pWoundAfterRaiseCalculator);
+    try {
+        AttackPipeline attack(nAttackDieSides, nWildDieSides, dMod, vDamageDice, nRaiseDieSides, vToughness.front(), bShaken);
+        if (dMemoryBudget>.0)
+            attack.setMemoryBudget(std::size_t(dMemoryBudget*1024.*1024.));
+        else
+            attack.setCache(std::make_shared<DistributionCache>());
+        auto pHitRaises = attack.getHitRaises();
+        std::cout << "Attacking with D"<<nAttackDieSides;
+        if (nWildDieSides>0)
+            std::cout << " and D"<<nWildDieSides;
+        std::cout << " "<<std::showpos<<dMod<<std::noshowpos<<", damage ";
+        for (std::size_t i=0; i<vDamageDice.size(); ++i)
+            std::cout << (i>0?"+":"")<<"D"<<vDamageDice[i];
+        if (nRaiseDieSides>0)
+            std::cout << " (+D"<<nRaiseDieSides<<" on a raise)";
+        std::cout << std::endl;
+        std::cout << "Probability of hitting: "<<std::fixed<<std::setprecision(2)<<100.*(1.-pHitRaises->distributionFunction(.0))<<"%"<<std::endl;
+        std::cout << "Probability of a raise: "<<100.*(1.-pHitRaises->distributionFunction(1.))<<"%"<<std::endl;
+        std::cout << "Expected damage: "<<attack.getDamage()->mean()<<" (on a raise: "<<attack.getRaiseDamage()->mean()<<")"<<std::endl;
+        std::cout << resetiosflags(std::ios_base::floatfield);
 
-    branchObject->vBranches.insert(Branch(pNoHitDmg, 0.));
-    branchObject->vBranches.insert(Branch(pWoundCalculator, 1.));
-    double total = .0;
-    for (double x=0; x<5;++x) {
-        auto p1=branchObject->distributionFunction(x);
-        auto p2=branchObject->distributionFunction(x-1.);
-        auto p = p1-p2;
-        std::cout << x << "    "<<p1-p2<<std::endl;
-        total +=p;
+        for (auto dToughness: vToughness) {
+            attack.setToughness(dToughness);
+            attack.setShaken(bShaken);
+            auto pWounds = attack.getWounds();
+            std::cout << "Against Toughness "<<dToughness<<(bShaken?" (shaken)":"")<<":"<<std::endl;
+            for (double x=0; x<5; ++x) {
+                std::cout << "  "<<x<<" Wounds:  "<<std::fixed<<std::setprecision(2)
+                          <<100.*(pWounds->distributionFunction(x)-pWounds->distributionFunction(x-1.))<<"%"<<std::endl;
+                std::cout << resetiosflags(std::ios_base::floatfield);
+            }
+            std::cout << "  >4 Wounds:  "<<std::fixed<<std::setprecision(2)<<100.*(1.-pWounds->distributionFunction(4.))<<"%"<<std::endl;
+            std::cout << "  Expected Wounds: "<<pWounds->mean()<<std::endl;
+            if (bJoint) {
+                auto pJoint = attack.getJointWounds();
+                std::cout << "  Wounds: 0       1       2       3       4       >4" << std::endl;
+                for (int nLevel: {1, 2}) {
+                    std::cout << (nLevel==1?"  Hit:    ":"  Raise:  ");
+                    // Row 2 and up are all raises.
+                    std::int64_t nLevelTo = nLevel==1 ? 1 : StochasticObject::nUnbounded;
+                    for (std::int64_t x=0; x<=5; ++x) {
+                        std::int64_t nWoundsTo = x<5 ? x : StochasticObject::nUnbounded;
+                        std::ostringstream sCell;
+                        sCell << std::fixed<<std::setprecision(2)<<100.*pJoint->getProbability(nLevel, nLevelTo, x, nWoundsTo)<<"%";
+                        std::cout << std::left<<std::setw(8)<<sCell.str()<<std::right;
+                    }
+                    std::cout << std::endl;
+                }
+            }
+            std::cout << resetiosflags(std::ios_base::floatfield);
+        }
+        if (dMemoryBudget>.0)
+            std::cout << "Probability cut off to fit "<<dMemoryBudget<<" MB: "<<attack.getTruncatedMass()<<std::endl;
+    } catch (std::string& sError) {
+        std::cout << sError << std::endl;
+        return 1;
     }
-    std::cout << "Total: "<<total << std::endl;
-    std::cout << "   >4: "<<1.-branchObject->distributionFunction(4.)<<std::endl;
+    return 0;
 }
-
-
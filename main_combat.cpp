@@ -0,0 +1,77 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include "SWTraitRoll.h"
+#include "AttackPipeline.h"
+#include "DistributionCache.h"
+#include "CombatEngine.h"
+
+int main(int argc, char* argv[]) {
+    if(argc == 1) {
+        std::cout << "Usage:\n"<<argv[0]<<" Rounds [AttacksPerRound] [Toughness] [MaxWounds] [SpiritDie]" << std::endl;
+        std::cout << "The Spirit die (rolled with a d6 Wild Die) is used to recover from being Shaken, 0 means never." << std::endl;
+        return 1;
+    }
+    unsigned int nRounds = std::stoul(std::string{argv[1]});
+    unsigned int nAttacks{1};
+    double dToughness{4.};
+    unsigned int nMaxWounds{3};
+    unsigned int nSpiritDieSides{0};
+    if(argc>2) {
+        nAttacks = std::stoul(std::string{argv[2]});
+    }
+    if(argc>3) {
+        dToughness = std::stod(std::string{argv[3]});
+    }
+    if(argc>4) {
+        nMaxWounds = std::stoul(std::string{argv[4]});
+    }
+    if(argc>5) {
+        nSpiritDieSides = std::stoul(std::string{argv[5]});
+    }
+
+    CombatEngine engine(nMaxWounds);
+    if(nSpiritDieSides>1) {
+        SWTraitRoll spiritRoll(nSpiritDieSides, 6);
+        engine.setUnshakeProbability(1.-spiritRoll.distributionFunction(.0));
+    }
+    AttackPipeline attack(4, 6, .0, {8, 6}, 6, dToughness, false);
+    attack.setCache(std::make_shared<DistributionCache>());
+    auto pWoundsVsUnshaken = attack.getWounds();
+    attack.setShaken(true);
+    auto pWoundsVsShaken = attack.getWounds();
+    for (unsigned int i=0; i<nAttacks; ++i)
+        engine.addAttack(pWoundsVsUnshaken, pWoundsVsShaken);
+
+    auto vState = engine.getStateDistribution(0);
+    std::cout << std::fixed << std::setprecision(2);
+    for (unsigned int nRound=1; nRound<=nRounds; ++nRound) {
+        vState = engine.advanceRound(vState);
+        std::cout << "After round "<<nRound<<":"<<std::endl;
+        for (unsigned int nWounds=0; nWounds<=nMaxWounds; ++nWounds) {
+            std::cout << "  "<<nWounds<<" Wounds:  "<<100.*vState[engine.getStateIndex(nWounds, false)]<<"%  "
+                      << "Shaken: "<<100.*vState[engine.getStateIndex(nWounds, true)]<<"%"<<std::endl;
+        }
+        std::cout << "  Incapacitated: "<<100.*vState[engine.getIncapacitatedIndex()]<<"%"<<std::endl;
+    }
+    std::cout << "Expected rounds until incapacitated: "<<engine.getExpectedRoundsUntilIncapacitated()<<std::endl;
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "AcingDie.h"
+#include "TabulatedObject.h"
+
+// Compares float, double and long double tables on the sum of many acing dice: time per chain,
+// memory of the result, the largest CDF difference to the long double result and the error bound
+// each table reports.
+
+void printUsage(const char* sName) {
+    std::cout << "Usage:\n"<<sName<<" [-d Die] [-n Dice] [-r Repeats] [-e Epsilon]" << std::endl;
+    std::cout << "  Defaults: -d 6 -n 32 -r 20 -e 1e-9" << std::endl;
+}
+
+template<typename Scalar>
+std::shared_ptr<BasicTabulatedObject<Scalar>> sumOfDice(unsigned int nDie, unsigned int nDice, double dEpsilon) {
+    AcingDie die(nDie);
+    BasicTabulatedObject<Scalar> single(die, dEpsilon);
+    auto pSum = std::make_shared<BasicTabulatedObject<Scalar>>(single);
+    for (unsigned int i=1; i<nDice; ++i)
+        pSum = BasicTabulatedObject<Scalar>::add(*pSum, single, dEpsilon);
+    return pSum;
+}
+
+template<typename Scalar>
+void benchmark(unsigned int nDie, unsigned int nDice, unsigned int nRepeats, double dEpsilon, const BasicTabulatedObject<long double>& exact) {
+    std::shared_ptr<BasicTabulatedObject<Scalar>> pSum;
+    auto tStart = std::chrono::steady_clock::now();
+    for (unsigned int i=0; i<nRepeats; ++i)
+        pSum = sumOfDice<Scalar>(nDie, nDice, dEpsilon);
+    std::chrono::duration<double, std::milli> tElapsed = std::chrono::steady_clock::now()-tStart;
+    double dError = .0, dTailError = .0;
+    auto nEnd = std::min(pSum->getIntMaximum(), exact.getIntMaximum());
+    for (auto n=pSum->getIntMinimum(); n<nEnd; ++n) {
+        dError = std::max(dError, std::fabs(pSum->cdfAt(n)-exact.cdfAt(n)));
+        // Relative error of P(X > n), where cancellation in 1 - CDF shows.
+        long double dSurvival = 1.L-(long double)(exact.cdfAt(n));
+        if (dSurvival>1e-6L)
+            dTailError = std::max(dTailError, double(std::fabs((1.L-(long double)(pSum->cdfAt(n)))/dSurvival-1.L)));
+    }
+    std::cout << std::left<<std::setw(13)<<BasicTabulatedObject<Scalar>::getScalarName()<<std::right
+              << std::fixed<<std::setprecision(3)<<std::setw(10)<<tElapsed.count()/nRepeats
+              << std::setw(10)<<pSum->getStoredSize()*sizeof(Scalar)
+              << std::scientific<<std::setprecision(2)<<std::setw(12)<<dError<<std::setw(12)<<pSum->getErrorBound()
+              << std::setw(12)<<dTailError<<std::setw(12)<<pSum->mean()-exact.mean()<<std::endl;
+    std::cout << resetiosflags(std::ios_base::floatfield);
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int nDie{6};
+    unsigned int nDice{32};
+    unsigned int nRepeats{20};
+    double dEpsilon{1e-9};
+    try {
+        for (int i=1; i<argc; ++i) {
+            std::string sArg{argv[i]};
+            if (sArg=="-h" || sArg=="--help" || i+1>=argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            std::string sValue{argv[++i]};
+            if (sArg=="-d")
+                nDie = std::stoul(sValue);
+            else if (sArg=="-n")
+                nDice = std::stoul(sValue);
+            else if (sArg=="-r")
+                nRepeats = std::stoul(sValue);
+            else if (sArg=="-e")
+                dEpsilon = std::stod(sValue);
+            else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (nDie<=1 || nDice<1 || nRepeats<1 || !(dEpsilon>.0)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        auto pExact = sumOfDice<long double>(nDie, nDice, dEpsilon);
+        std::cout << "Sum of "<<nDice<<" acing D"<<nDie<<", "<<nRepeats<<" repeats, errors against long double:" << std::endl;
+        std::cout << "precision      ms/sum     bytes   max error       bound  tail error  mean error" << std::endl;
+        benchmark<float>(nDie, nDice, nRepeats, dEpsilon, *pExact);
+        benchmark<double>(nDie, nDice, nRepeats, dEpsilon, *pExact);
+        benchmark<long double>(nDie, nDice, nRepeats, dEpsilon, *pExact);
+    } catch (std::string& sError) {
+        std::cout << sError << std::endl;
+        return 1;
+    }
+    return 0;
+}
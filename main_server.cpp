@@ -0,0 +1,235 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "BlockingQueue.h"
+#include "JsonObject.h"
+#include "ThreadPool.h"
+#include "RollServer.h"
+#include "DistributionCache.h"
+
+namespace {
+    // Requests waiting for or in computation; reading stops while this many are pending, which pushes
+    // back on the clients.
+    const std::size_t nMaxPending = 256;
+    const std::size_t nMaxLineLength = 1<<20;
+    const std::size_t nMaxConnections = 64;
+
+    // A bounded queue used as counting semaphore: push takes a slot, blocking while none is free, pop
+    // returns it.
+    typedef BlockingQueue<char> Slots;
+
+    std::string lineTooLong(void) {
+        return "{\"id\":null,\"error\":"+JsonObject::quote("Request longer than "+std::to_string(nMaxLineLength)+" bytes.")+"}";
+    }
+
+    class Connection {
+        private:
+            int fd;
+            std::mutex writeMutex;
+        public:
+            Connection(int fd_): fd(fd_) {};
+            ~Connection(void) {close(fd);};
+
+            int getFd(void) const {return fd;};
+            void writeLine(const std::string& sLine) {
+                std::unique_lock<std::mutex> lock(writeMutex);
+                std::string sData = sLine+"\n";
+                std::size_t nWritten = 0;
+                while (nWritten<sData.size()) {
+                    auto nResult = send(fd, sData.data()+nWritten, sData.size()-nWritten, MSG_NOSIGNAL);
+                    if (nResult<=0)
+                        return;
+                    nWritten += std::size_t(nResult);
+                }
+            }
+    };
+
+    void serveConnection(std::shared_ptr<Connection> pConnection, RollServer& server, ThreadPool& pool, Slots& pending) {
+        std::string sBuffer;
+        // Set while the rest of an overlong line is skipped.
+        bool bSkipping = false;
+        char aChunk[4096];
+        while (true) {
+            auto nRead = recv(pConnection->getFd(), aChunk, sizeof(aChunk), 0);
+            if (nRead<=0)
+                return;
+            sBuffer.append(aChunk, std::size_t(nRead));
+            std::size_t nNewline;
+            while ((nNewline = sBuffer.find('\n'))!=std::string::npos) {
+                std::string sLine = sBuffer.substr(0, nNewline);
+                sBuffer.erase(0, nNewline+1);
+                if (bSkipping) {
+                    bSkipping = false;
+                    continue;
+                }
+                if (sLine.size()>nMaxLineLength) {
+                    pConnection->writeLine(lineTooLong());
+                    continue;
+                }
+                if (sLine.find_first_not_of(" \t\r")==std::string::npos)
+                    continue;
+                auto tReceived = std::chrono::steady_clock::now();
+                pending.push(0);
+                pool.submit([pConnection, sLine, tReceived, &server, &pending](){
+                    pConnection->writeLine(server.handleRequest(sLine, tReceived));
+                    char c;
+                    pending.pop(c);
+                });
+            }
+            if (sBuffer.size()>nMaxLineLength) {
+                if (!bSkipping)
+                    pConnection->writeLine(lineTooLong());
+                bSkipping = true;
+                sBuffer.clear();
+            }
+        }
+    }
+
+    int serveSocket(const std::string& sPath, RollServer& server, ThreadPool& pool, Slots& pending) {
+        int nListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (nListenFd<0) {
+            std::cerr << "Could not create socket: "<<std::strerror(errno)<<std::endl;
+            return 1;
+        }
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (sPath.size()>=sizeof(address.sun_path)) {
+            std::cerr << "Socket path too long."<<std::endl;
+            return 1;
+        }
+        std::strncpy(address.sun_path, sPath.c_str(), sizeof(address.sun_path)-1);
+        unlink(sPath.c_str());
+        if (bind(nListenFd, (sockaddr*)&address, sizeof(address))<0 || listen(nListenFd, 16)<0) {
+            std::cerr << "Could not listen on "<<sPath<<": "<<std::strerror(errno)<<std::endl;
+            close(nListenFd);
+            return 1;
+        }
+        // Further clients wait in the listen backlog until a connection closes.
+        Slots connections(nMaxConnections);
+        while (true) {
+            connections.push(0);
+            int nFd = accept(nListenFd, nullptr, nullptr);
+            if (nFd<0) {
+                char c;
+                connections.pop(c);
+                if (errno==EINTR)
+                    continue;
+                std::cerr << "accept failed: "<<std::strerror(errno)<<std::endl;
+                break;
+            }
+            auto pConnection = std::make_shared<Connection>(nFd);
+            std::thread([pConnection, &server, &pool, &pending, &connections](){
+                serveConnection(pConnection, server, pool, pending);
+                char c;
+                connections.pop(c);
+            }).detach();
+        }
+        close(nListenFd);
+        unlink(sPath.c_str());
+        return 1;
+    }
+
+    // Like std::getline, but keeps at most nMaxLineLength characters and reports longer lines.
+    bool readLine(std::istream& input, std::string& sLine, bool& bTooLong) {
+        sLine.clear();
+        bTooLong = false;
+        auto pBuffer = input.rdbuf();
+        int c = pBuffer->sbumpc();
+        if (c==std::char_traits<char>::eof())
+            return false;
+        for (; c!=std::char_traits<char>::eof() && c!='\n'; c = pBuffer->sbumpc()) {
+            if (sLine.size()<nMaxLineLength)
+                sLine += char(c);
+            else
+                bTooLong = true;
+        }
+        return true;
+    }
+
+    int serveStdin(RollServer& server, ThreadPool& pool, Slots& pending) {
+        std::mutex outputMutex;
+        std::string sLine;
+        bool bTooLong;
+        while (readLine(std::cin, sLine, bTooLong)) {
+            if (bTooLong) {
+                std::unique_lock<std::mutex> lock(outputMutex);
+                std::cout << lineTooLong() << std::endl;
+                continue;
+            }
+            if (sLine.find_first_not_of(" \t\r")==std::string::npos)
+                continue;
+            auto tReceived = std::chrono::steady_clock::now();
+            pending.push(0);
+            pool.submit([sLine, tReceived, &server, &outputMutex, &pending](){
+                auto sResponse = server.handleRequest(sLine, tReceived);
+                {
+                    std::unique_lock<std::mutex> lock(outputMutex);
+                    std::cout << sResponse << std::endl;
+                }
+                char c;
+                pending.pop(c);
+            });
+        }
+        pool.wait();
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string sSocketPath;
+    unsigned int nThreads{0};
+    for (int i=1; i<argc; ++i) {
+        std::string sArg{argv[i]};
+        if (sArg=="--socket" && i+1<argc) {
+            sSocketPath = argv[++i];
+        } else if (sArg=="--threads" && i+1<argc) {
+            nThreads = std::stoul(std::string{argv[++i]});
+        } else {
+            std::cout << "Usage:\n"<<argv[0]<<" [--socket Path] [--threads N]" << std::endl;
+            std::cout << "Reads one JSON request per line from stdin (or each connection to the Unix socket)" << std::endl;
+            std::cout << "and answers each with one JSON line, e.g." << std::endl;
+            std::cout << "  {\"id\":1,\"type\":\"trait\",\"die\":8,\"wild\":6,\"mod\":1,\"rerolls\":0}" << std::endl;
+            std::cout << "  {\"id\":2,\"type\":\"attack\",\"attack\":8,\"damage\":[8,6],\"raise\":6,\"toughness\":5,\"shaken\":false}" << std::endl;
+            std::cout << "  {\"id\":3,\"type\":\"expression\",\"expr\":\"wounds(d8!+d6!+$bonus, T=6, shaken)\",\"bonus\":2}" << std::endl;
+            std::cout << "  {\"id\":4,\"type\":\"sweep\",\"of\":\"trait\",\"die\":6,\"parameter\":\"mod\",\"from\":-4,\"to\":4}" << std::endl;
+            std::cout << "  {\"id\":5,\"type\":\"stats\"}" << std::endl;
+            std::cout << "Lines are limited to "<<nMaxLineLength<<" bytes, at most "<<nMaxPending<<" requests are pending and at most "
+                      << nMaxConnections<<" connections served at once." << std::endl;
+            return 1;
+        }
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    RollServer server(std::make_shared<DistributionCache>());
+    ThreadPool pool(nThreads);
+    Slots pending(nMaxPending);
+    if (!sSocketPath.empty())
+        return serveSocket(sSocketPath, server, pool, pending);
+    return serveStdin(server, pool, pending);
+}
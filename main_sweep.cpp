@@ -0,0 +1,75 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <string>
+#include "SweepJob.h"
+
+void printUsage(const char* sName) {
+    std::cout << "Usage:\n"<<sName<<" Directory [--of trait|attack] [--dice LIST] [--wild LIST] [--mods LIST] [--rerolls LIST]\n"
+              << "    [--damage PROFILES] [--raise Die] [--toughness LIST] [--shaken LIST] [--chunk N] [--threads N]" << std::endl;
+    std::cout << "  LIST is e.g. 4,6,8 or -4:4, PROFILES e.g. 8+6|10+8. --damage, --raise, --toughness and --shaken apply to attacks." << std::endl;
+    std::cout << "  Finished chunks are kept in Directory; run the same command (or just \""<<sName<<" Directory\") to resume." << std::endl;
+    std::cout << "  The result is Directory/results.csv." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc<2 || std::string{argv[1]}=="-h" || std::string{argv[1]}=="--help") {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::string sDirectory{argv[1]};
+    std::string sDefinition;
+    std::size_t nThreads{0};
+    try {
+        for (int i=2; i<argc; ++i) {
+            std::string sArg{argv[i]};
+            if (sArg.size()<3 || sArg.compare(0, 2, "--")!=0 || i+1>=argc) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            std::string sValue{argv[++i]};
+            if (sArg=="--threads")
+                nThreads = std::stoul(sValue);
+            else
+                sDefinition += sArg.substr(2)+"="+sValue+";";
+        }
+    } catch (std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        auto definition = sDefinition.empty() ? SweepJob::readDefinition(sDirectory) : SweepJob::Definition::fromString(sDefinition);
+        SweepJob job(sDirectory, definition);
+        if (job.isMerged()) {
+            std::cout << "Sweep already finished: "<<job.getResultPath()<<std::endl;
+            return 0;
+        }
+        if (job.getFinishedChunkCount()>0)
+            std::cout << "Resuming, "<<job.getFinishedChunkCount()<<" of "<<job.getChunkCount()<<" chunks done." << std::endl;
+        job.run(nThreads, [](std::size_t nDone, std::size_t nTotal){
+            std::cerr << "\rChunk "<<nDone<<" of "<<nTotal<<std::flush;
+        });
+        std::cerr << std::endl;
+        std::cout << definition.getPointCount()<<" points written to "<<job.getResultPath()<<std::endl;
+    } catch (std::string& sError) {
+        std::cout << sError << std::endl;
+        return 1;
+    }
+    return 0;
+}
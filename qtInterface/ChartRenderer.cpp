@@ -0,0 +1,216 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <QCoreApplication>
+#include <QImage>
+#include <QPainter>
+#include <QPen>
+#include <QtCharts/QBarSeries>
+#include <QtCharts/QBarSet>
+
+#include "ChartRenderer.h"
+#include "../SWTraitRoll.h"
+#include "../ThreadPool.h"
+
+ChartRenderer::ChartRenderer(QSize size_, int nPlotRaiseNumber_, bool bDisplayExactProbabilities_): size(size_), nPlotRaiseNumber(nPlotRaiseNumber_),
+        bDisplayExactProbabilities(bDisplayExactProbabilities_) {
+    chart = new QtCharts::QChart();
+    chart->setAnimationOptions(QtCharts::QChart::NoAnimation);
+
+    axisX = new QtCharts::QBarCategoryAxis();
+    axisX->append(getCategories(nPlotRaiseNumber, bDisplayExactProbabilities));
+    chart->addAxis(axisX, Qt::AlignBottom);
+
+    axisY = new QtCharts::QValueAxis();
+    QPen penYAxisLines;
+    penYAxisLines.setStyle(Qt::DashLine);
+    penYAxisLines.setBrush(Qt::lightGray);
+    axisY->setGridLinePen(penYAxisLines);
+    chart->addAxis(axisY, Qt::AlignLeft);
+    axisY->setTickCount(10);
+
+    pChartView = std::make_unique<QtCharts::QChartView>(chart);
+    pChartView->setRenderHint(QPainter::Antialiasing);
+    // The view has to be laid out once for the chart to get its geometry, but must never appear.
+    pChartView->setAttribute(Qt::WA_DontShowOnScreen);
+    pChartView->resize(size);
+    pChartView->show();
+}
+
+ChartRenderer::~ChartRenderer(void) = default;
+
+std::vector<double> ChartRenderer::computeBarValues(const TabulatedObject& table, int nPlotRaiseNumber_, bool bDisplayExactProbabilities_) {
+    std::vector<double> vValues;
+    for(double x=-1.;x<nPlotRaiseNumber_+2;++x) {
+        if(bDisplayExactProbabilities_ || x<1.)
+            vValues.push_back(100.*(table.distributionFunction(x) - table.distributionFunction(x-1.)));
+        else
+            vValues.push_back(100.*(1. - table.distributionFunction(x-1.)));
+    }
+    if(bDisplayExactProbabilities_)
+        vValues.push_back(100.*(1.-table.distributionFunction(nPlotRaiseNumber_+1.)));
+    return vValues;
+}
+
+QStringList ChartRenderer::getCategories(int nPlotRaiseNumber_, bool bDisplayExactProbabilities_) {
+    QStringList categories;
+    categories << "Critical Fail"<<"(Non-Crit) Fail"<<(bDisplayExactProbabilities_?"Success":">=Success");
+    for (int i=1; i<nPlotRaiseNumber_+1; ++i) {
+        std::stringstream s;
+        s<<"Success + "<<(bDisplayExactProbabilities_?"":">=")<<i<<(i==1?" Raise":" Raises");
+        categories<<s.str().c_str();
+    }
+    if(bDisplayExactProbabilities_) {
+        std::stringstream s;
+        s<<"Success + >="<<nPlotRaiseNumber_+1<<" Raises";
+        categories<<s.str().c_str();
+    }
+    return categories;
+}
+
+std::vector<ChartRenderer::Job> ChartRenderer::parseJobs(std::istream& input) {
+    std::vector<Job> vJobs;
+    std::string sLine;
+    int nLine = 0;
+    while (std::getline(input, sLine)) {
+        ++nLine;
+        std::istringstream line(sLine);
+        std::string sFileName;
+        if (!(line>>sFileName) || sFileName[0]=='#')
+            continue;
+        Job job;
+        job.sFileName = QString::fromStdString(sFileName);
+        std::string sRest;
+        std::getline(line, sRest);
+        std::istringstream rolls(sRest);
+        std::string sRoll;
+        while (std::getline(rolls, sRoll, ';')) {
+            std::istringstream roll(sRoll);
+            unsigned int nTrait = 0, nWild = 6;
+            int nMod = 0, nRerolls = 0;
+            if (!(roll>>nTrait)) {
+                std::stringstream s;
+                s<<"Line "<<nLine<<": expected trait die sides";
+                throw s.str();
+            }
+            if (roll>>nMod && roll>>nWild)
+                roll>>nRerolls;
+            job.vRolls.push_back(std::make_shared<SWTraitRoll>(nTrait, nWild, nMod, nRerolls));
+            if (!job.sTitle.isEmpty())
+                job.sTitle += "  vs.  ";
+            job.sTitle += QString::fromStdString(job.vRolls.back()->getDescription());
+        }
+        if (job.vRolls.empty()) {
+            std::stringstream s;
+            s<<"Line "<<nLine<<": no roll given for "<<sFileName;
+            throw s.str();
+        }
+        vJobs.push_back(std::move(job));
+    }
+    return vJobs;
+}
+
+void ChartRenderer::drawChart(const QString& sTitle, const std::vector<std::vector<double>>& vValues) {
+    chart->setTitle(sTitle);
+    chart->removeAllSeries();
+    auto series = new QtCharts::QBarSeries;
+    double max = -std::numeric_limits<double>::infinity();
+    for (std::size_t i=0; i<vValues.size(); ++i) {
+        auto set0 = std::make_unique<QtCharts::QBarSet>(QString("Roll ")+QString::number(i+1));
+        for (auto p: vValues[i]) {
+            *set0 << p;
+            max = std::max(max, p);
+        }
+        series->append(set0.release());
+    }
+    if(max<0.) max = 1.;
+    axisY->setRange(0.,std::ceil(max/10.)*10.);
+    chart->addSeries(series);
+    series->attachAxis(axisX);
+    series->attachAxis(axisY);
+}
+
+std::size_t ChartRenderer::renderAll(const std::vector<Job>& vJobs, std::shared_ptr<DistributionCache> pCache, std::size_t nThreads) {
+    // Tabulate every distinct roll once, in parallel.
+    std::map<std::string, std::shared_ptr<StochasticObject>> mRolls;
+    for (auto &job: vJobs)
+        for (auto &pRoll: job.vRolls)
+            mRolls.emplace(pRoll->getDescription(), pRoll);
+    std::map<std::string, std::vector<double>> mValues;
+    std::map<std::string, std::string> mErrors;
+    std::mutex resultMutex;
+    {
+        ThreadPool pool(std::min<std::size_t>(nThreads>0?nThreads:std::thread::hardware_concurrency(), std::max<std::size_t>(mRolls.size(), 1)));
+        int nRaises = nPlotRaiseNumber;
+        bool bExact = bDisplayExactProbabilities;
+        for (auto &entry: mRolls) {
+            pool.submit([&entry, &pCache, &mValues, &mErrors, &resultMutex, nRaises, bExact](){
+                try {
+                    auto vValues = computeBarValues(*pCache->getTabulated(*entry.second), nRaises, bExact);
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    mValues[entry.first] = std::move(vValues);
+                } catch (const std::string& sError) {
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    mErrors[entry.first] = sError;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    axisX->setCategories(getCategories(nPlotRaiseNumber, bDisplayExactProbabilities));
+    std::size_t nWritten = 0;
+    for (auto &job: vJobs) {
+        std::vector<std::vector<double>> vValues;
+        std::string sError;
+        for (auto &pRoll: job.vRolls) {
+            auto sDescription = pRoll->getDescription();
+            if (mErrors.count(sDescription)) {
+                sError = mErrors[sDescription];
+                break;
+            }
+            vValues.push_back(mValues[sDescription]);
+        }
+        if (!sError.empty()) {
+            std::cerr<<job.sFileName.toStdString()<<": "<<sError<<std::endl;
+            continue;
+        }
+        drawChart(job.sTitle, vValues);
+        // Let the chart lay out the new series before painting it.
+        QCoreApplication::processEvents();
+        QImage image(size, QImage::Format_ARGB32);
+        image.fill(Qt::white);
+        QPainter p(&image);
+        pChartView->render(&p);
+        p.end();
+        if (image.save(job.sFileName, "PNG"))
+            ++nWritten;
+        else
+            std::cerr<<job.sFileName.toStdString()<<": could not write file"<<std::endl;
+    }
+    return nWritten;
+}
@@ -0,0 +1,77 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __CHARTRENDERER_H__
+#define __CHARTRENDERER_H__
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QtCharts/QChartView>
+#include <QtCharts/QBarCategoryAxis>
+#include <QtCharts/QValueAxis>
+
+#include "../DistributionCache.h"
+#include "../StochasticObject.h"
+#include "../TabulatedObject.h"
+
+// Draws success/raise bar charts into PNG files without showing a window. A single QChart and
+// QChartView are reused for every chart; all distributions are computed in parallel before the
+// first chart is drawn, since drawing has to happen on the GUI thread.
+class ChartRenderer {
+    public:
+        struct Job {
+            QString sFileName;
+            QString sTitle;
+            std::vector<std::shared_ptr<StochasticObject>> vRolls;
+        };
+    private:
+        QtCharts::QChart *chart;
+        QtCharts::QBarCategoryAxis *axisX;
+        QtCharts::QValueAxis *axisY;
+        std::unique_ptr<QtCharts::QChartView> pChartView;
+
+        QSize size;
+        int nPlotRaiseNumber;
+        bool bDisplayExactProbabilities;
+
+        void drawChart(const QString& sTitle, const std::vector<std::vector<double>>& vValues);
+    public:
+        ChartRenderer(QSize size_=QSize(900,600), int nPlotRaiseNumber_=4, bool bDisplayExactProbabilities_=true);
+        ~ChartRenderer(void);
+        ChartRenderer(const ChartRenderer&) = delete;
+        ChartRenderer& operator=(const ChartRenderer&) = delete;
+
+        // Renders every job into its file and returns the number of files written. Failures are
+        // reported on stderr and do not stop the remaining jobs. nThreads = 0 uses all hardware threads.
+        std::size_t renderAll(const std::vector<Job>& vJobs, std::shared_ptr<DistributionCache> pCache, std::size_t nThreads=0);
+
+        // One line per chart: "FILE TRAIT [MOD [WILD [REROLLS]]]", more rolls on the same chart separated
+        // by ';'. Empty lines and lines starting with '#' are skipped. Throws a string on malformed lines.
+        static std::vector<Job> parseJobs(std::istream& input);
+
+        // Bar heights in percent, in the order of getCategories().
+        static std::vector<double> computeBarValues(const TabulatedObject& table, int nPlotRaiseNumber_, bool bDisplayExactProbabilities_);
+        static QStringList getCategories(int nPlotRaiseNumber_, bool bDisplayExactProbabilities_);
+};
+
+#endif
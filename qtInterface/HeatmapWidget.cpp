@@ -0,0 +1,141 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <cmath>
+
+#include <QPainter>
+#include <QMouseEvent>
+#include <QToolTip>
+#include <QPen>
+
+#include "HeatmapWidget.h"
+
+// Space for the die labels on the left and the modifier labels below.
+static const int nLabelWidth = 40;
+static const int nLabelHeight = 20;
+
+HeatmapWidget::HeatmapWidget(QWidget *parent_): QWidget(parent_), pGrid(nullptr), nHoverRow(-1), nHoverColumn(-1) {
+    setMouseTracking(true);
+    setMinimumSize(200, 120);
+}
+
+void HeatmapWidget::setGrid(const std::shared_ptr<const SuccessGrid>& pGrid_) {
+    pGrid = pGrid_;
+    cellImage = pGrid ? renderCells(*pGrid) : QImage();
+    nHoverRow = nHoverColumn = -1;
+    update();
+}
+
+QRgb HeatmapWidget::colorFor(double dProbability) {
+    static const int aStops[3][3] = {{68, 1, 84}, {33, 145, 140}, {253, 231, 37}};
+    double dT = std::min(1., std::max(.0, dProbability))*2.;
+    int nStop = std::min(1, int(dT));
+    double dF = dT-double(nStop);
+    int aColor[3];
+    for (int i=0; i<3; ++i)
+        aColor[i] = int(std::lround(aStops[nStop][i]+(aStops[nStop+1][i]-aStops[nStop][i])*dF));
+    return qRgb(aColor[0], aColor[1], aColor[2]);
+}
+
+QImage HeatmapWidget::renderCells(const SuccessGrid& grid) {
+    QImage image(int(grid.getColumns()), int(grid.getRows()), QImage::Format_RGB32);
+    for (std::size_t r=0; r<grid.getRows(); ++r) {
+        auto pLine = reinterpret_cast<QRgb*>(image.scanLine(int(r)));
+        for (std::size_t c=0; c<grid.getColumns(); ++c)
+            pLine[c] = colorFor(grid.at(r, c));
+    }
+    return image;
+}
+
+QString HeatmapWidget::describeCell(const SuccessGrid& grid, std::size_t nRow, std::size_t nColumn) {
+    int nMod = grid.getMod(nColumn);
+    return QString("d%1 %2%3: %4% for at least %5 Successes & Raises")
+        .arg(grid.getTraitDie(nRow)).arg(nMod<0?"":"+").arg(nMod)
+        .arg(100.*grid.at(nRow, nColumn), 0, 'f', 2).arg(grid.getLevel());
+}
+
+void HeatmapWidget::paintHeatmap(QPainter& painter, const QRect& target, const SuccessGrid& grid, const QImage& cells, int nHoverRow, int nHoverColumn) {
+    QRect area(target.left()+nLabelWidth, target.top(), target.width()-nLabelWidth, target.height()-nLabelHeight);
+    if (area.width()<=0 || area.height()<=0)
+        return;
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter.drawImage(area, cells);
+
+    double dCellWidth = double(area.width())/double(grid.getColumns());
+    double dCellHeight = double(area.height())/double(grid.getRows());
+    painter.setPen(Qt::black);
+    for (std::size_t r=0; r<grid.getRows(); ++r) {
+        QRectF label(target.left(), area.top()+dCellHeight*double(r), nLabelWidth-4, dCellHeight);
+        if (dCellHeight>=10. || r%std::size_t(std::ceil(10./dCellHeight))==0)
+            painter.drawText(label, Qt::AlignRight|Qt::AlignVCenter, QString("d%1").arg(grid.getTraitDie(r)));
+    }
+    // Label every modifier that leaves room for about 30 pixels of text.
+    std::size_t nStep = std::max<std::size_t>(1, std::size_t(std::ceil(30./dCellWidth)));
+    for (std::size_t c=0; c<grid.getColumns(); c+=nStep) {
+        QRectF label(area.left()+dCellWidth*(double(c)+.5)-15., area.bottom()+2, 30, nLabelHeight-2);
+        int nMod = grid.getMod(c);
+        painter.drawText(label, Qt::AlignHCenter|Qt::AlignTop, QString("%1%2").arg(nMod<0?"":"+").arg(nMod));
+    }
+    if (nHoverRow>=0 && nHoverColumn>=0) {
+        painter.setPen(QPen(Qt::white, 2));
+        painter.drawRect(QRectF(area.left()+dCellWidth*nHoverColumn, area.top()+dCellHeight*nHoverRow, dCellWidth, dCellHeight));
+    }
+}
+
+QRect HeatmapWidget::getCellArea(void) const {
+    return QRect(nLabelWidth, 0, width()-nLabelWidth, height()-nLabelHeight);
+}
+
+void HeatmapWidget::paintEvent(QPaintEvent*) {
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().window());
+    if (!pGrid)
+        return;
+    paintHeatmap(painter, rect(), *pGrid, cellImage, nHoverRow, nHoverColumn);
+}
+
+void HeatmapWidget::mouseMoveEvent(QMouseEvent *ev) {
+    if (!pGrid)
+        return;
+    QRect area = getCellArea();
+    int nRow = -1, nColumn = -1;
+    if (area.contains(ev->pos())) {
+        nRow = std::min(int(pGrid->getRows())-1, int(double(ev->pos().y()-area.top())*double(pGrid->getRows())/double(area.height())));
+        nColumn = std::min(int(pGrid->getColumns())-1, int(double(ev->pos().x()-area.left())*double(pGrid->getColumns())/double(area.width())));
+    }
+    if (nRow==nHoverRow && nColumn==nHoverColumn)
+        return;
+    nHoverRow = nRow;
+    nHoverColumn = nColumn;
+    // Only the cell lookup and an overlay change, the cell image is reused as is.
+    update();
+    if (nRow<0) {
+        QToolTip::hideText();
+        emit cellHovered(QString());
+        return;
+    }
+    auto sDescription = describeCell(*pGrid, std::size_t(nRow), std::size_t(nColumn));
+    QToolTip::showText(ev->globalPos(), sDescription, this);
+    emit cellHovered(sDescription);
+}
+
+void HeatmapWidget::leaveEvent(QEvent*) {
+    nHoverRow = nHoverColumn = -1;
+    update();
+    emit cellHovered(QString());
+}
@@ -0,0 +1,62 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __HEATMAPWIDGET_H__
+#define __HEATMAPWIDGET_H__
+
+#include <memory>
+
+#include <QWidget>
+#include <QImage>
+#include <QString>
+
+#include "../SuccessGrid.h"
+
+// Draws a SuccessGrid as a heatmap. The cells are rendered once into a QImage with one pixel per cell,
+// which is scaled on painting, so redraws and hovering stay cheap even with thousands of cells.
+class HeatmapWidget: public QWidget {
+    Q_OBJECT
+    private:
+        std::shared_ptr<const SuccessGrid> pGrid;
+        QImage cellImage;
+        int nHoverRow;
+        int nHoverColumn;
+
+        QRect getCellArea(void) const;
+    protected:
+        void paintEvent(QPaintEvent *ev);
+        void mouseMoveEvent(QMouseEvent *ev);
+        void leaveEvent(QEvent *ev);
+    public:
+        HeatmapWidget(QWidget *parent_=nullptr);
+        virtual ~HeatmapWidget(void) = default;
+
+        void setGrid(const std::shared_ptr<const SuccessGrid>& pGrid_);
+
+        // One pixel per cell, trait dice from top to bottom and modifiers from left to right.
+        static QImage renderCells(const SuccessGrid& grid);
+        // Dark blue for 0 through green to yellow for 1.
+        static QRgb colorFor(double dProbability);
+        // Paints the labelled heatmap into target, also used to save it as image.
+        static void paintHeatmap(QPainter& painter, const QRect& target, const SuccessGrid& grid, const QImage& cells, int nHoverRow=-1, int nHoverColumn=-1);
+        static QString describeCell(const SuccessGrid& grid, std::size_t nRow, std::size_t nColumn);
+
+    signals:
+        void cellHovered(const QString& sDescription);
+};
+
+#endif
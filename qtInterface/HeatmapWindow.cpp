@@ -0,0 +1,90 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QGridLayout>
+
+#include "HeatmapWindow.h"
+
+HeatmapWindow::HeatmapWindow(QWidget *parent_): QWidget(parent_) {
+    setWindowTitle("SW Roll Calculator Heatmap");
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    QGridLayout *gridLayout = new QGridLayout(this);
+    gridLayout->addWidget(new QLabel("Wild Die", this), 1, 1);
+    wildDieComboBox = new QComboBox(this);
+    wildDieComboBox->addItem("d4");
+    wildDieComboBox->addItem("d6");
+    wildDieComboBox->addItem("d8");
+    wildDieComboBox->addItem("d10");
+    wildDieComboBox->addItem("d12");
+    wildDieComboBox->setCurrentIndex(1);
+    gridLayout->addWidget(wildDieComboBox, 1, 2);
+
+    gridLayout->addWidget(new QLabel("Rerolls", this), 1, 3);
+    rerollsSpinBox = new QSpinBox(this);
+    rerollsSpinBox->setMinimum(0);
+    gridLayout->addWidget(rerollsSpinBox, 1, 4);
+
+    gridLayout->addWidget(new QLabel("At least Successes & Raises", this), 1, 5);
+    levelSpinBox = new QSpinBox(this);
+    levelSpinBox->setRange(1, 20);
+    levelSpinBox->setValue(1);
+    gridLayout->addWidget(levelSpinBox, 1, 6);
+
+    gridLayout->addWidget(new QLabel("Modifiers from", this), 2, 1);
+    modFromSpinBox = new QSpinBox(this);
+    modFromSpinBox->setRange(-500, 500);
+    modFromSpinBox->setValue(-6);
+    gridLayout->addWidget(modFromSpinBox, 2, 2);
+    gridLayout->addWidget(new QLabel("to", this), 2, 3);
+    modToSpinBox = new QSpinBox(this);
+    modToSpinBox->setRange(-500, 500);
+    modToSpinBox->setValue(6);
+    gridLayout->addWidget(modToSpinBox, 2, 4);
+
+    heatmap = new HeatmapWidget(this);
+    gridLayout->addWidget(heatmap, 3, 1, 1, 6);
+    gridLayout->setRowStretch(3, 1);
+    hoverLabel = new QLabel(this);
+    gridLayout->addWidget(hoverLabel, 4, 1, 1, 6);
+
+    QObject::connect(wildDieComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int){this->updateHeatmap();});
+    for (auto spinBox: {rerollsSpinBox, levelSpinBox, modFromSpinBox, modToSpinBox})
+        QObject::connect(spinBox, QOverload<int>::of(&QSpinBox::valueChanged), [this](int){this->updateHeatmap();});
+    QObject::connect(heatmap, &HeatmapWidget::cellHovered, hoverLabel, &QLabel::setText);
+
+    resize(700, 400);
+    updateHeatmap();
+}
+
+void HeatmapWindow::updateHeatmap(void) {
+    int nModFrom = modFromSpinBox->value();
+    int nModTo = std::max(nModFrom, modToSpinBox->value());
+    try {
+        auto pGrid = std::make_shared<SuccessGrid>(std::vector<unsigned int>{12, 10, 8, 6, 4}, nModFrom, nModTo,
+                2*(wildDieComboBox->currentIndex()+2), rerollsSpinBox->value(), levelSpinBox->value());
+        heatmap->setGrid(pGrid);
+        hoverLabel->setText(QString());
+    } catch (std::string& sError) {
+        hoverLabel->setText(QString::fromStdString(sError));
+    }
+}
@@ -0,0 +1,46 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef __HEATMAPWINDOW_H__
+#define __HEATMAPWINDOW_H__
+
+#include <QWidget>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QLabel>
+
+#include "HeatmapWidget.h"
+
+// Success probabilities for all trait dice against a range of modifiers, as a heatmap.
+class HeatmapWindow: public QWidget {
+    Q_OBJECT
+    private:
+        QComboBox *wildDieComboBox;
+        QSpinBox *rerollsSpinBox;
+        QSpinBox *levelSpinBox;
+        QSpinBox *modFromSpinBox;
+        QSpinBox *modToSpinBox;
+        HeatmapWidget *heatmap;
+        QLabel *hoverLabel;
+
+        void updateHeatmap(void);
+    public:
+        HeatmapWindow(QWidget *parent_=nullptr);
+        virtual ~HeatmapWindow(void) = default;
+};
+
+#endif
@@ -27,10 +27,16 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 #include <QImage>
 #include <QPainter>
 #include <QMenuBar>
+#include <QCoreApplication>
 
 #include "MainQtWindow.h"
 
-MainQtWindow::MainQtWindow(QWidget* parent_): QWidget(parent_), nRCWCount(0), nPlotRaiseNumber(4), bDisplayExactProbabilities(true), optionsWindow(new OptionsMenu(*this, nullptr)) {
+MainQtWindow::MainQtWindow(QWidget* parent_): QWidget(parent_), series(nullptr), nRCWCount(0), nPlotRaiseNumber(4), bDisplayExactProbabilities(true), optionsWindow(new OptionsMenu(*this, nullptr)), pCache(std::make_shared<DistributionCache>()),
+        pRefinementPool(new ThreadPool(1)), nChartGeneration(0) {
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    QObject::connect(refreshTimer, &QTimer::timeout, [this](){this->updateChart();});
+
     chart = new QtCharts::QChart();
     chart->setTitle("Probabilities of Success and Failure");
     chart->setAnimationOptions(QtCharts::QChart::SeriesAnimations);
@@ -65,10 +71,13 @@ MainQtWindow::MainQtWindow(QWidget* parent_): QWidget(parent_), nRCWCount(0), nP
 
     QPushButton *addRCWButton = new QPushButton("Add Roll", buttonBox);
     QPushButton *plotButton = new QPushButton("Plot", buttonBox);
+    QPushButton *heatmapButton = new QPushButton("Heatmap", buttonBox);
+    QObject::connect(heatmapButton, QOverload<bool>::of(&QPushButton::clicked), [](bool){HeatmapWindow *hw = new HeatmapWindow; hw->show();});
     QObject::connect(plotButton, QOverload<bool>::of(&QPushButton::clicked), [this](bool){this->updateChart();});
     QObject::connect(addRCWButton, QOverload<bool>::of(&QPushButton::clicked), [this](bool){this->addRCW();});
     buttonBoxLayout->addWidget(addRCWButton);
     buttonBoxLayout->addWidget(plotButton);
+    buttonBoxLayout->addWidget(heatmapButton);
     plotButton->resize(80,20);
     addRCWButton->resize(80,20);
 
@@ -100,54 +109,69 @@ MainQtWindow::MainQtWindow(QWidget* parent_): QWidget(parent_), nRCWCount(0), nP
 }
 
 MainQtWindow::~MainQtWindow(void) {
+    // Make queued refinements skip their work, then wait for the running one.
+    ++nChartGeneration;
+    pRefinementPool.reset();
+}
+
+void MainQtWindow::scheduleChartUpdate(void) {
+    refreshTimer->start(nDebounceMilliseconds);
+}
 
+void MainQtWindow::scheduleRefinement(const std::vector<std::shared_ptr<StochasticObject>>& vRolls) {
+    unsigned int nGeneration = nChartGeneration;
+    auto pRefinementCache = pCache;
+    int nRaises = nPlotRaiseNumber;
+    bool bExact = bDisplayExactProbabilities;
+    pRefinementPool->submit([this, nGeneration, vRolls, pRefinementCache, nRaises, bExact](){
+        std::vector<std::vector<double>> vValues;
+        for (auto &pRoll: vRolls) {
+            if (nGeneration!=nChartGeneration)
+                return;
+            vValues.push_back(ChartRenderer::computeBarValues(*pRefinementCache->getTabulated(*pRoll), nRaises, bExact));
+        }
+        QMetaObject::invokeMethod(this, [this, nGeneration, vValues](){this->applyRefinement(nGeneration, vValues);}, Qt::QueuedConnection);
+    });
 }
 
-double MainQtWindow::fillBarSetFromStochasticObject(QtCharts::QBarSet& set, const std::shared_ptr<StochasticObject>& pStochasticObject) {
+void MainQtWindow::applyRefinement(unsigned int nGeneration, const std::vector<std::vector<double>>& vValues) {
+    if (nGeneration!=nChartGeneration || !series)
+        return;
+    auto sets = series->barSets();
+    if (std::size_t(sets.size())!=vValues.size())
+        return;
     double max = -std::numeric_limits<double>::infinity();
-    set.remove(0, set.count());
-    for(double x=-1.;x<nPlotRaiseNumber+2;++x) {
-        double p = .0;
-        if(bDisplayExactProbabilities || x<1.)
-            p = 100.*(pStochasticObject->distributionFunction(x) - pStochasticObject->distributionFunction(x-1.));
-        else
-            p = 100.*(1. - pStochasticObject->distributionFunction(x-1.));
-        set << p;
-        max = std::max(p,max);
-    }
-    if(bDisplayExactProbabilities) {
-        double p =100.*(1.-pStochasticObject->distributionFunction(nPlotRaiseNumber+1.));
-        max = std::max(p,max);
-        set << p;
+    for (int i=0; i<sets.size(); ++i) {
+        for (std::size_t j=0; j<vValues[i].size() && int(j)<sets[i]->count(); ++j) {
+            sets[i]->replace(int(j), vValues[i][j]);
+            max = std::max(max, vValues[i][j]);
+        }
     }
-    return max;
+    if(max<0.) max = 1.;
+    axisY->setRange(0.,std::ceil(max/10.)*10.);
 }
 
 void MainQtWindow::updateChart(void) {
-    QStringList categories;
-    categories << "Critical Fail"<<"(Non-Crit) Fail"<<(bDisplayExactProbabilities?"Success":">=Success");
-    for (int i=1; i<nPlotRaiseNumber+1; ++i) {
-        std::stringstream s;
-        s<<"Success + "<<(bDisplayExactProbabilities?"":">=")<<i<<(i==1?" Raise":" Raises");
-        categories<<s.str().c_str();
-    }
-    if(bDisplayExactProbabilities) {
-        std::stringstream s;
-        s<<"Success + >="<<nPlotRaiseNumber+1<<" Raises";
-        categories<<s.str().c_str();
-    }
+    refreshTimer->stop();
+    ++nChartGeneration;
     delete axisX;
     axisX = new QtCharts::QBarCategoryAxis();
-    axisX->append(categories);
+    axisX->append(ChartRenderer::getCategories(nPlotRaiseNumber, bDisplayExactProbabilities));
 
     chart->addAxis(axisX, Qt::AlignBottom);
     chart->removeAllSeries();
-    auto series = new QtCharts::QBarSeries;
+    series = new QtCharts::QBarSeries;
     auto count = 1;
     double max = -std::numeric_limits<double>::infinity();
+    std::vector<std::shared_ptr<StochasticObject>> vRolls;
     for (auto rcw :RollSetupRow->findChildren<RollCompositionWidget*>()){
         auto set0 = std::make_unique<QtCharts::QBarSet>(QString("Roll ")+QString::number(count));
-        max = std::max(max,fillBarSetFromStochasticObject(*set0, rcw->getRoll()));
+        vRolls.push_back(rcw->getRoll());
+        // Coarse first, so the chart follows the inputs without delay.
+        for (auto p: ChartRenderer::computeBarValues(TabulatedObject(*vRolls.back(), dCoarseEpsilon), nPlotRaiseNumber, bDisplayExactProbabilities)) {
+            *set0 << p;
+            max = std::max(max, p);
+        }
         series->append(set0.release());
         ++count;
     }
@@ -161,6 +185,7 @@ void MainQtWindow::updateChart(void) {
     series->attachAxis(axisX);
     series->attachAxis(axisY);
 
+    scheduleRefinement(vRolls);
 }
 
 void MainQtWindow::addRCW(void) {
@@ -169,10 +194,12 @@ void MainQtWindow::addRCW(void) {
     auto newRCW = (RollCompositionWidget*)HBoxLayout->itemAt(nRCWCount)->widget();
     newRCW->setMinimumWidth(150);
     auto deleteItButton = newRCW->getDeleteMeButton();
-    QObject::connect(deleteItButton, QOverload<bool>::of(&QPushButton::clicked), [newRCW,this](bool){--(this->nRCWCount); delete newRCW;});
+    QObject::connect(deleteItButton, QOverload<bool>::of(&QPushButton::clicked), [newRCW,this](bool){--(this->nRCWCount); delete newRCW; this->scheduleChartUpdate();});
+    QObject::connect(newRCW, &RollCompositionWidget::rollChanged, [this](){this->scheduleChartUpdate();});
 
     HBoxLayout->invalidate();
     ++nRCWCount;
+    scheduleChartUpdate();
 }
 
 void MainQtWindow::hoveredBar(bool status, int index, QtCharts::QBarSet* set) {
@@ -205,7 +232,7 @@ void MainQtWindow::exportCSV(void) {
         fsCSVFile<<std::endl;
     int rollIndex=1;
     for (auto rcw :RollSetupRow->findChildren<RollCompositionWidget*>()){
-        auto roll = rcw->getRoll();
+        auto roll = pCache->getTabulated(*rcw->getRoll());
         fsCSVFile<<"Roll "<<rollIndex<<", ";
         for(double x=-1.;x<nPlotRaiseNumber+2;++x) {
             double p = .0;
@@ -225,6 +252,9 @@ void MainQtWindow::exportCSV(void) {
 
 void MainQtWindow::exportPNG(void) {
     updateChart();
+    // Save the refined chart, not the coarse one.
+    pRefinementPool->wait();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
     QFileDialog saveFileDialog(this, tr("Save Plot to PNG"),"",tr("PNG Images (*.png);;All Files (*)"));
     saveFileDialog.setDefaultSuffix(".png");
     saveFileDialog.setFileMode(QFileDialog::AnyFile);
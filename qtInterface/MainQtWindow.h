@@ -18,7 +18,9 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef __MAINQTWINDOW_H__
 #define __MAINQTWINDOW_H__
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include <QtWidgets/QMainWindow>
 #include <QtCharts/QChartView>
@@ -31,11 +33,16 @@ along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QFrame>
+#include <QTimer>
 
 class MainQtWindow;
 
+#include "../DistributionCache.h"
+#include "../ThreadPool.h"
 #include "RollCompositionWidget.h"
 #include "InfoWindow.h"
+#include "HeatmapWindow.h"
+#include "ChartRenderer.h"
 #include "OptionsMenu.h"
 
 class MainQtWindow: public QWidget {
@@ -48,13 +55,24 @@ class MainQtWindow: public QWidget {
         QVBoxLayout *VBoxLayout;
         QHBoxLayout *HBoxLayout;
         QWidget *RollSetupRow;
+        QtCharts::QBarSeries *series;
+        QTimer *refreshTimer;
 
         int nPlotRaiseNumber;
         int nRCWCount;
         bool bDisplayExactProbabilities;
         std::unique_ptr<OptionsMenu> optionsWindow;
+        std::shared_ptr<DistributionCache> pCache;
 
-        double fillBarSetFromStochasticObject(QtCharts::QBarSet& set, const std::shared_ptr<StochasticObject>& pStochasticObject);
+        // The chart is first drawn from coarse tables, then a background thread replaces the bars with
+        // accurate values. Every new chart increases nChartGeneration, which makes older refinements stale.
+        std::unique_ptr<ThreadPool> pRefinementPool;
+        std::atomic<unsigned int> nChartGeneration;
+        static constexpr double dCoarseEpsilon = 1e-3;
+        static constexpr int nDebounceMilliseconds = 150;
+
+        void scheduleRefinement(const std::vector<std::shared_ptr<StochasticObject>>& vRolls);
+        void applyRefinement(unsigned int nGeneration, const std::vector<std::vector<double>>& vValues);
 
         void hoveredBar(bool status, int index, QtCharts::QBarSet* set);
         void createMenuBar(void);
@@ -64,6 +82,8 @@ class MainQtWindow: public QWidget {
         ~MainQtWindow(void);
 
         void updateChart(void);
+        // Redraws the chart once the inputs have not changed for nDebounceMilliseconds.
+        void scheduleChartUpdate(void);
         void addRCW(void);
         void exportCSV(void);
         void exportPNG(void);
@@ -84,23 +84,28 @@ std::shared_ptr<StochasticObject> RollCompositionWidget::getRoll(void) const {
 
 void RollCompositionWidget::traitDieChanged(int newIndex) {
     nTraitDieSides = 2*(newIndex+2);
+    emit rollChanged();
 }
 
 
 void RollCompositionWidget::wildDieChanged(int newIndex) {
     nWildDieSides = 2*(newIndex+2);
+    emit rollChanged();
 }
 
 void RollCompositionWidget::modifierChanged(int val) {
     nMod = val;
+    emit rollChanged();
 }
 
 void RollCompositionWidget::rerollsChanged(int val) {
     nRerolls = val;
+    emit rollChanged();
 }
 
 void RollCompositionWidget::targetNumberChanged(int val) {
     nTargetNumber = val;
+    emit rollChanged();
 }
 
 void RollCompositionWidget::resizeEvent(QResizeEvent* ev) {
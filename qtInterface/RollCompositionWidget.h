@@ -50,6 +50,10 @@ class RollCompositionWidget: public QFrame {
         int getRerolls() {return nRerolls;};
 
         QPushButton *getDeleteMeButton(void) {return deleteMeButton;};
+
+    signals:
+        // Emitted whenever one of the inputs changes.
+        void rollChanged(void);
 };
 
 #endif
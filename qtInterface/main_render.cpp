@@ -0,0 +1,98 @@
+/*
+Copyright 2021 Wilhelm Neubert
+This file is part of SW Roll Calculator.
+
+SW Roll Calculator is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+SW Roll Calculator is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with SW Roll Calculator.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <QtWidgets/QApplication>
+
+#include "ChartRenderer.h"
+
+int main( int argc, char **argv )
+{
+    // No display needed unless the caller asks for a different platform plugin.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a( argc, argv );
+
+    std::vector<std::string> vJobFiles;
+    int nWidth = 900, nHeight = 600;
+    int nPlotRaiseNumber = 4;
+    bool bDisplayExactProbabilities = true;
+    long nThreads = 0;
+    try {
+        for (int i=1; i<argc; ++i) {
+            std::string sArgument{argv[i]};
+            bool bHasValue = i+1<argc;
+            if (sArgument=="--width" && bHasValue)
+                nWidth = std::stoi(std::string{argv[++i]});
+            else if (sArgument=="--height" && bHasValue)
+                nHeight = std::stoi(std::string{argv[++i]});
+            else if (sArgument=="--raises" && bHasValue)
+                nPlotRaiseNumber = std::stoi(std::string{argv[++i]});
+            else if (sArgument=="--threads" && bHasValue)
+                nThreads = std::stol(std::string{argv[++i]});
+            else if (sArgument=="--at-least")
+                bDisplayExactProbabilities = false;
+            else
+                vJobFiles.push_back(sArgument);
+        }
+    } catch (const std::exception&) {
+        vJobFiles.clear();
+    }
+    if (vJobFiles.empty() || nWidth<=0 || nHeight<=0 || nPlotRaiseNumber<0 || nThreads<0) {
+        std::cout << "Usage:\n"<<argv[0]<<" JobFile... [Options]\n"
+                  << "Each line of a JobFile (- for standard input) describes one chart:\n"
+                  << "  FILE.png TraitDie [Modifier [WildDie [Rerolls]]] [; TraitDie ...]\n"
+                  << "Options:\n"
+                  << "  --width N      image width in pixels (default 900)\n"
+                  << "  --height N     image height in pixels (default 600)\n"
+                  << "  --raises N     number of Raises shown separately (default 4)\n"
+                  << "  --at-least     show probabilities of at least N Successes & Raises\n"
+                  << "  --threads N    threads computing the distributions (default: all)" << std::endl;
+        return 1;
+    }
+
+    std::vector<ChartRenderer::Job> vJobs;
+    try {
+        for (auto &sJobFile: vJobFiles) {
+            std::vector<ChartRenderer::Job> vFileJobs;
+            if (sJobFile=="-") {
+                vFileJobs = ChartRenderer::parseJobs(std::cin);
+            } else {
+                std::ifstream input(sJobFile);
+                if (!input) {
+                    std::cerr << "Could not open "<<sJobFile << std::endl;
+                    return 1;
+                }
+                vFileJobs = ChartRenderer::parseJobs(input);
+            }
+            vJobs.insert(vJobs.end(), vFileJobs.begin(), vFileJobs.end());
+        }
+    } catch (const std::string& sError) {
+        std::cerr << sError << std::endl;
+        return 1;
+    }
+
+    ChartRenderer renderer(QSize(nWidth, nHeight), nPlotRaiseNumber, bDisplayExactProbabilities);
+    auto nWritten = renderer.renderAll(vJobs, std::make_shared<DistributionCache>(), (std::size_t)nThreads);
+    std::cout << "Wrote "<<nWritten<<" of "<<vJobs.size()<<" charts." << std::endl;
+    return nWritten==vJobs.size() ? 0 : 1;
+}